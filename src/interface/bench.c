@@ -0,0 +1,194 @@
+// bench.c
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "bench.h"
+#include "ui.h"
+#include "../movefinding/board.h"
+#include "../search/search.h"
+#include "../search/hash_tables.h"
+#include "../search/timeman.h"
+
+#define BENCH_MAX_TIME 1000000000LL
+
+// the stress keys share this many buckets, so stores keep colliding
+#define TT_STRESS_BUCKETS 8
+#define TT_STRESS_KEYS 256
+#define TT_STRESS_MAX_THREADS 64
+#define TT_FILE_CHECK_KEYS 4096
+
+static const char *bench_positions[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r2q1rk1/1pp1nppp/8/p1b1p3/2PpP1n1/PP1P2N1/2Q2PPP/RNB2RK1 w - - 0 13",
+    "r1b1kbn1/pp1ppppp/8/6Nr/2p5/5PP1/1P1PPRRP/1N2BBKR w - - 0 1",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2QKB1R w KQ - 0 8",
+    "6k1/1K6/4q3/3B4/2P5/5b2/8/8 w - - 0 1",
+    "1k6/4N3/8/8/8/5rr1/2K5/8 w - - 0 1",
+    "3krr2/8/8/8/8/8/3K4/8 w - - 20 21",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+void run_bench(uint8_t depth)
+{
+    ULL total_nodes = 0;
+    LL total_ms = 0;
+    size_t num_positions = sizeof(bench_positions) / sizeof(bench_positions[0]);
+
+    for (size_t i = 0; i < num_positions; i++) {
+        char fen[FEN_LENGTH];
+        Position_t position, best_move;
+
+        strncpy(fen, bench_positions[i], FEN_LENGTH - 1);
+        fen[FEN_LENGTH - 1] = '\0';
+        fen_to_board(fen, &position);
+        hash_table_new_game();
+        insert_past_move_entry(&position);
+
+        LL start = get_monotonic_ms();
+        find_best_move(&position, &best_move, depth,
+                       time_limits_fixed(BENCH_MAX_TIME));
+        LL elapsed = get_monotonic_ms() - start;
+        clear_past_move_entry();
+
+        ULL nodes = get_nodes_analysed();
+        total_nodes += nodes;
+        total_ms += elapsed;
+        printf("Position %zu/%zu: %s%s | Nodes: %llu | Time: %lld ms\n",
+               i + 1, num_positions,
+               pretty_print_moves[best_move.from_sq],
+               pretty_print_moves[best_move.to_sq],
+               nodes, elapsed);
+    }
+
+    printf("\nBench depth %u | Nodes: %llu | Time: %lld ms | NPS: %llu\n",
+           depth, total_nodes, total_ms,
+           total_ms > 0 ? total_nodes * 1000ULL / (ULL)total_ms : 0ULL);
+}
+
+// ------------------------------------------------------------------
+// Transposition table stress test
+// ------------------------------------------------------------------
+
+static ULL stress_keys[TT_STRESS_KEYS];
+
+typedef struct {
+    ULL seed;
+    LL end_ms;
+    ULL probes;
+    ULL hits;
+    ULL stores;
+    ULL torn;
+} StressThread_t;
+
+// the result every store of a key writes, so a hit can be checked
+static inline Move_t stress_move(ULL key) { return (Move_t)(key >> 16); }
+static inline int32_t stress_eval(ULL key) { return (int32_t)(key >> 32); }
+
+static inline ULL xorshift64(ULL *state)
+{
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void *tt_stress_loop(void *arg)
+{
+    StressThread_t *thread = arg;
+    ULL rng = thread->seed;
+
+    while (get_monotonic_ms() < thread->end_ms) {
+        for (int i = 0; i < 4096; i++) {
+            ULL r = xorshift64(&rng);
+            ULL key = stress_keys[r % TT_STRESS_KEYS];
+
+            if (r & (1ULL << 40)) {
+                tt_store(key, stress_eval(key), (uint8_t)(r >> 48) & 63,
+                         (NodeType_t)((r >> 56) % 3), stress_move(key));
+                thread->stores++;
+                continue;
+            }
+
+            TranspositionData_t data;
+            thread->probes++;
+            if (!tt_probe(key, 0, &data)) { continue; }
+            thread->hits++;
+            if (data.move != stress_move(key) || data.eval != stress_eval(key)) {
+                thread->torn++;
+            }
+        }
+    }
+    return NULL;
+}
+
+ULL run_tt_stress(int num_threads, int seconds)
+{
+    if (num_threads < 1) { num_threads = 1; }
+    if (num_threads > TT_STRESS_MAX_THREADS) { num_threads = TT_STRESS_MAX_THREADS; }
+
+    ULL rng = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < TT_STRESS_KEYS; i++) {
+        stress_keys[i] = (xorshift64(&rng) & ~tt_mask) | (ULL)(i % TT_STRESS_BUCKETS);
+    }
+
+    pthread_t threads[TT_STRESS_MAX_THREADS];
+    StressThread_t states[TT_STRESS_MAX_THREADS] = {0};
+    LL end_ms = get_monotonic_ms() + (LL)seconds * 1000;
+    for (int i = 0; i < num_threads; i++) {
+        states[i].seed = xorshift64(&rng);
+        states[i].end_ms = end_ms;
+        pthread_create(&threads[i], NULL, tt_stress_loop, &states[i]);
+    }
+
+    ULL probes = 0, hits = 0, stores = 0, torn = 0;
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+        probes += states[i].probes;
+        hits += states[i].hits;
+        stores += states[i].stores;
+        torn += states[i].torn;
+    }
+
+    printf("TT stress %d threads | Probes: %llu | Hits: %llu | Stores: %llu | Torn: %llu\n",
+           num_threads, probes, hits, stores, torn);
+    return torn;
+}
+
+// ------------------------------------------------------------------
+// Transposition table file check
+// ------------------------------------------------------------------
+
+bool run_tt_file_check(const char *path)
+{
+    // one key per bucket, so no result is replaced while filling
+    size_t num_keys = TT_FILE_CHECK_KEYS;
+    if (num_keys > (size_t)tt_mask + 1) { num_keys = (size_t)tt_mask + 1; }
+    ULL rng = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < num_keys; i++) {
+        ULL key = (xorshift64(&rng) & ~tt_mask) | (ULL)i;
+        tt_store(key, stress_eval(key), (uint8_t)(i & 63), EXACT, stress_move(key));
+    }
+
+    // the second save writes over the file the table is mapped from
+    bool success = hash_table_save(path) && hash_table_load(path)
+                && hash_table_save(path) && hash_table_load(path);
+
+    size_t found = 0;
+    rng = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; success && i < num_keys; i++) {
+        ULL key = (xorshift64(&rng) & ~tt_mask) | (ULL)i;
+        TranspositionData_t data;
+        if (tt_probe(key, 0, &data) && data.move == stress_move(key)
+            && data.eval == stress_eval(key) && data.depth == (uint8_t)(i & 63)) {
+            found++;
+        }
+    }
+
+    printf("TT file check %s | Saved and loaded twice: %s | Results found: %zu/%zu\n",
+           path, success ? "yes" : "no", found, num_keys);
+    return success && found == num_keys;
+}
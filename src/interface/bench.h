@@ -0,0 +1,57 @@
+/**
+ * @file bench.h
+ * @brief Fixed-depth search benchmark
+ * @author Philip Brand
+ * @date 2026-10-19
+ *
+ * Searches a fixed set of positions to a fixed depth and reports nodes,
+ * time and nodes per second, so search changes can be compared.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+#include "../movefinding/board.h"
+
+#define BENCH_DEPTH 7
+
+#define TT_STRESS_THREADS 4
+#define TT_STRESS_SECONDS 5
+
+/**
+ * @brief Runs the benchmark over the bench position set.
+ *
+ * Move finding, hash tables and the memory pool must already be initialised.
+ *
+ * @param depth The depth each position is searched to.
+ */
+void run_bench(uint8_t depth);
+
+/**
+ * @brief Stresses concurrent transposition table access.
+ *
+ * Threads store and probe a small set of keys that all fall into a few
+ * buckets, and every hit is checked against the result stored for its
+ * key. Overwrites the transposition table.
+ *
+ * @param num_threads Number of threads probing and storing.
+ * @param seconds How long to run for.
+ * @return The number of hits that returned another key's result.
+ */
+ULL run_tt_stress(int num_threads, int seconds);
+
+/**
+ * @brief Checks saving and loading the transposition table through one file.
+ *
+ * Fills the table with known results, saves it to path, loads it back,
+ * saves the loaded (mapped) table over the same path and loads it again,
+ * then probes every result. Overwrites the transposition table.
+ *
+ * @param path The file to be used, overwritten.
+ * @return Whether every result survived.
+ */
+bool run_tt_file_check(const char *path);
+
+#endif // BENCH_H
@@ -13,11 +13,11 @@
 #include "../movefinding/movefinder.h"
 #include "../gui/log.h"
 
-#define MILLISECONDS_IN_SECOND 100
+#define MILLISECONDS_IN_SECOND 1000
 
 static bool white_perspective = true; // Default perspective for printing the board
 
-static uint16_t max_engine_search_time = 5;
+static LL max_engine_search_time = 5 * MILLISECONDS_IN_SECOND;
 static uint16_t user_time_increment = 0;
 static uint16_t game_length_per_side = 0;
 static uint16_t half_move_count = 0;
@@ -49,12 +49,6 @@ const char *header_fmt =
     "|==================================================\n"
     "\n";
 
-LL get_monotonic_ms(void) {
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000LL;
-}
-
 void ui_init(void)
 {
     time_t now = time(NULL);
@@ -87,20 +81,11 @@ void clear_output_screen(uint8_t x)
 void start_clock(void)
 { current_player_start_time = get_monotonic_ms(); }
 
-LL get_next_move_search_time(void)
+TimeLimits_t get_next_move_search_time(void)
 {
-    if (!playing_with_clock) { return max_engine_search_time;}
-    else { 
-        if (half_move_count < 2 ) {
-            return max_engine_search_time * MILLISECONDS_IN_SECOND / 60;
-        } else if (half_move_count < 10) {
-            return engine_time_remaining / 60;
-        } else if (half_move_count < 50) {
-            return engine_time_remaining / 30;
-        } else {
-            return engine_time_remaining / 20;
-        }
-    }
+    if (!playing_with_clock) { return time_limits_fixed(max_engine_search_time); }
+    // only the user is given an increment
+    return time_limits_from_clock(engine_time_remaining, 0, half_move_count);
 }
 
 void switch_time_decrement(void)
@@ -166,6 +151,18 @@ bool is_game_ended(Position_t *position)
             write_result_to_log(2);
             }
             return true;
+        case FIFTY_MOVE_RULE:
+            if (!web_build) {
+            printf("Fifty moves without a capture or pawn move! Game drawn.\n");
+            write_result_to_log(2);
+            }
+            return true;
+        case INSUFFICIENT_MATERIAL:
+            if (!web_build) {
+            printf("Insufficient material! Game drawn.\n");
+            write_result_to_log(2);
+            }
+            return true;
         case BORING:
             return false;
         default:
@@ -177,13 +174,14 @@ void set_search_time(void)
 {
     printf("\nPlease enter the maximum engine search time per move (in seconds)");
     printf("\n(Recommended: 1-5 seconds): ");
-    if (scanf("%hu", &max_engine_search_time) != 1 || max_engine_search_time == 0) {
+    uint16_t search_time_seconds;
+    if (scanf("%hu", &search_time_seconds) != 1 || search_time_seconds == 0) {
         fprintf(stderr, "Invalid input. ");
         clear_input_buffer();
         set_search_time(); // Retry if input is invalid
     } else {
-        max_engine_search_time *= MILLISECONDS_IN_SECOND; // Convert to milliseconds
-        printf("Maximum search time set to %hu seconds.\n\n", max_engine_search_time / MILLISECONDS_IN_SECOND);
+        max_engine_search_time = (LL)search_time_seconds * MILLISECONDS_IN_SECOND; // Convert to milliseconds
+        printf("Maximum search time set to %hu seconds.\n\n", search_time_seconds);
         clear_input_buffer();
     }
 }
@@ -197,9 +195,8 @@ void set_time_control(void)
         clear_input_buffer();
     } else {
         printf("Game length per side set to %hu seconds.\n", game_length_per_side);
-        user_time_remaining = game_length_per_side * MILLISECONDS_IN_SECOND; // Convert to clock ticks
-        engine_time_remaining = game_length_per_side * MILLISECONDS_IN_SECOND; // Convert to clock ticks
-        max_engine_search_time = game_length_per_side;
+        user_time_remaining = (LL)game_length_per_side * MILLISECONDS_IN_SECOND; // Convert to milliseconds
+        engine_time_remaining = (LL)game_length_per_side * MILLISECONDS_IN_SECOND; // Convert to milliseconds
     }
     printf("\nPlease enter the user time increment between moves in seconds: ");
     // Prompt for user time increment
@@ -217,7 +214,7 @@ void set_time(uint32_t time)
 {
     if (time != 0) {
         playing_with_clock = false;
-        max_engine_search_time = time * MILLISECONDS_IN_SECOND;
+        max_engine_search_time = (LL)time * MILLISECONDS_IN_SECOND;
         return;
     }
 
@@ -319,14 +316,57 @@ int make_move_from_san(Position_t *source, Position_t *destination, const char*
     return 1; // Move successfully made
 }
 
+bool is_san_of_move(Position_t *source, Position_t *destination, const char* move_notation)
+{
+    MoveType_t move_type;
+    uint8_t to_square = 0;
+    char disambiguation[2] = "\0";
+    bool is_capture = false;
+    ULL special_flags = 0;
+
+    if (strlen(move_notation) < 2) { return false; }
+    if (!parse_move_notation(move_notation,
+                             &move_type,
+                             &to_square,
+                             disambiguation,
+                             &is_capture,
+                             source,
+                             &special_flags)) {
+        return false;
+    }
+
+    ULL from_square_bitboard = determine_from_square_bitboard(source, move_type, to_square, disambiguation);
+    ULL move_from_bitboard, move_to_bitboard;
+    find_from_to_square(source, destination, &move_from_bitboard, &move_to_bitboard);
+    if (from_square_bitboard != move_from_bitboard || (1ULL << to_square) != move_to_bitboard) {
+        return false;
+    }
+
+    // promotions to different pieces share their from and to squares
+    switch (move_type) {
+        case PROMOTE_QUEEN:
+        case PROMOTE_ROOK:
+        case PROMOTE_BISHOP:
+        case PROMOTE_KNIGHT:
+            return move_type == find_move_type(source, destination);
+        default:
+            return true;
+    }
+}
+
+void read_move_from_cli(char *move_notation)
+{
+    printf("Enter move: ");
+    if (fgets(move_notation, MOVE_LENGTH, stdin) == NULL) { move_notation[0] = '\0'; }
+    move_notation[strcspn(move_notation, "\n")] = 0; // Remove newline character
+}
+
 void make_move_from_cli(Position_t *position, Position_t *move_position)
 {
     char move_notation[MOVE_LENGTH];
     bool finished = false;
     while (!finished) {
-        printf("Enter move: ");
-        if (fgets(move_notation, MOVE_LENGTH, stdin) == NULL) { }
-        move_notation[strcspn(move_notation, "\n")] = 0; // Remove newline character
+        read_move_from_cli(move_notation);
         finished = make_move_from_san(position, move_position, move_notation);
     }
 }
@@ -340,6 +380,8 @@ void print_welcome_message(void)
 {
     printf("Welcom to TessMax!\n");
     printf("When prompted, please enter your move.\n");
+    printf("Instead of a move, \"hash <MB>\" resizes the transposition table\n");
+    printf("and \"clearhash\" clears it.\n");
     printf("BE AWARE: Mistakes in your input can lead to unexpected behavior!\n");
     printf("To terminate the game, press ctrl + C twice.\n\n");
 }
@@ -388,6 +430,19 @@ void print_position(Position_t* position)
     }
 }
 
+void print_search_lines(const SearchLine_t* lines, uint8_t num_lines)
+{
+    char move_string[MOVE_STRING_LENGTH];
+    for (uint8_t i = 0; i < num_lines; i++) {
+        printf("%u. depth %u score %d pv", i + 1, lines[i].depth, lines[i].score);
+        for (uint8_t j = 0; j < lines[i].pv_length; j++) {
+            move_to_string(lines[i].pv[j], move_string);
+            printf(" %s", move_string);
+        }
+        printf("\n");
+    }
+}
+
 bool is_colour_set(void)
 { return colour_set; }
 
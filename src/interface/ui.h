@@ -11,8 +11,10 @@
 #include <stdint.h>
 
 #include "../movefinding/board.h"
+#include "../search/timeman.h"
+#include "../search/search.h"
 
-#define MOVE_LENGTH 10
+#define MOVE_LENGTH 16 // also holds CLI commands, e.g. "hash 16384"
 #define HEADER_LENGTH 1024
 
 #define COLOUR_BOLD "\e[1m"
@@ -36,6 +38,14 @@ void ui_init(void);
  */
 void print_position(Position_t* position);
 
+/**
+ * @brief Prints MultiPV search lines, one per line, best first.
+ *
+ * @param lines The lines found by find_best_moves().
+ * @param num_lines The number of lines to print.
+ */
+void print_search_lines(const SearchLine_t* lines, uint8_t num_lines);
+
 /**
  * @brief Makes a move from command line input.
  * 
@@ -47,6 +57,25 @@ void print_position(Position_t* position);
  */
 void make_move_from_cli(Position_t *position, Position_t *move_position);
 
+/**
+ * @brief Reads one move in SAN notation from the command line.
+ *
+ * @param move_notation Buffer of MOVE_LENGTH characters for the move.
+ */
+void read_move_from_cli(char *move_notation);
+
+/**
+ * @brief Checks whether a move in SAN notation leads to a given position.
+ *
+ * Does not generate moves, so it is safe to call while a search runs.
+ *
+ * @param position Pointer to the current position.
+ * @param move_position Pointer to the position after the expected move.
+ * @param san_move The move in Standard Algebraic Notation (SAN).
+ * @return true if san_move is the move from position to move_position.
+ */
+bool is_san_of_move(Position_t *position, Position_t *move_position, const char* san_move);
+
 /**
  * @brief Makes a move from SAN notation.
  * 
@@ -95,11 +124,14 @@ void set_colour(bool* playing_as_white);
 void set_time(uint32_t time);
 
 /**
- * @brief Gets the next move search time.
+ * @brief Gets the time limits for the engine's next move.
+ *
+ * Uses the fixed time per move, or an allocation from the engine's
+ * remaining clock time when playing with a clock.
  *
- * @return The time in milliseconds for the next move search.
+ * @return The soft and hard limits for the next move search.
  */
-LL get_next_move_search_time(void);
+TimeLimits_t get_next_move_search_time(void);
 
 /**
  * @brief Starts the clock for the current player.
@@ -9,18 +9,26 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include <SDL2/SDL.h>
 
 #include "./movefinding/movefinder.h"
 #include "./movefinding/board.h"
 #include "./movefinding/memory.h"
+#include "./movefinding/lookuptables.h"
 #include "./search/search.h"
 #include "./search/hash_tables.h"
+#include "./search/ponder.h"
 #include "./gui/gui.h"
 #include "./interface/ui.h"
+#include "./interface/bench.h"
 #include "./gui/log.h"
 
+#define ANALYSIS_LINES 3
+#define ANALYSIS_SECONDS 5
+
 static bool playing_as_white = false; // Default perspective for printing the board
 
 #define new "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
@@ -34,24 +42,98 @@ static Position_t position; // Current position of the game
 static Position_t move_position; // Position after the last move
 
 static GUI_Args_t gui_args; // Arguments for the GUI thread
+static const char *save_hash_path = NULL; // --save-hash file, written on exit
 
 /**
     * TODO:
-    * - display principal variation
     * - implement multi-threading
     * - improve position evaluation
     * - implement quiescence search
 */
 
 bool play_game(Position_t* position);
+bool play_ponder_hit(void);
 bool update_game(void);
-void init(void);
+void init(size_t hash_mb);
+void save_hash(void);
+bool run_cli_command(const char *input);
 void* cli_game_loop(void* arg);
 
-int main(void)
+int main(int argc, char *argv[])
 {
-    init();
+    // options before the mode, for any mode:
+    // --hash <MB> - transposition table size
+    // --load-hash <file> - start from a saved transposition table
+    // --save-hash <file> - save the transposition table on exit
+    size_t hash_mb = DEFAULT_HASH_MB;
+    const char *load_hash_path = NULL;
+    while (argc > 2) {
+        if (strcmp(argv[1], "--hash") == 0) {
+            hash_mb = (size_t)strtoull(argv[2], NULL, 10);
+        } else if (strcmp(argv[1], "--load-hash") == 0) {
+            load_hash_path = argv[2];
+        } else if (strcmp(argv[1], "--save-hash") == 0) {
+            save_hash_path = argv[2];
+        } else {
+            break;
+        }
+        argc -= 2;
+        argv += 2;
+    }
+
+    init(hash_mb);
+    if (load_hash_path) { hash_table_load(load_hash_path); }
+
+    // ./tessmax bench [depth] - fixed-depth search benchmark, no GUI
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        run_bench(argc > 2 ? (uint8_t)atoi(argv[2]) : BENCH_DEPTH);
+        save_hash();
+        custom_memory_deinit();
+        hash_table_free();
+        return 0;
+    }
+
+    // ./tessmax ttstress [threads] [seconds] - concurrent TT access check
+    if (argc > 1 && strcmp(argv[1], "ttstress") == 0) {
+        ULL torn = run_tt_stress(argc > 2 ? atoi(argv[2]) : TT_STRESS_THREADS,
+                                 argc > 3 ? atoi(argv[3]) : TT_STRESS_SECONDS);
+        custom_memory_deinit();
+        hash_table_free();
+        return torn ? 1 : 0;
+    }
+
+    // ./tessmax ttfilecheck <file> - save/load round trip through one file
+    if (argc > 2 && strcmp(argv[1], "ttfilecheck") == 0) {
+        bool ok = run_tt_file_check(argv[2]);
+        custom_memory_deinit();
+        hash_table_free();
+        return ok ? 0 : 1;
+    }
+
+    // ./tessmax analyse "<fen>" [lines] [seconds] - MultiPV analysis, no GUI
+    if (argc > 2 && strcmp(argv[1], "analyse") == 0) {
+        uint8_t num_lines = argc > 3 ? (uint8_t)atoi(argv[3]) : ANALYSIS_LINES;
+        long long seconds = argc > 4 ? atoll(argv[4]) : ANALYSIS_SECONDS;
+        SearchLine_t lines[MAX_CHILDREN];
+        if (num_lines > MAX_CHILDREN) { num_lines = MAX_CHILDREN; }
+
+        set_search_info_output(true);
+        fen_to_board(argv[2], &position);
+        clear_past_move_entry();
+        insert_past_move_entry(&position);
+        hash_table_new_game();
+        num_lines = find_best_moves(&position, lines, num_lines,
+                                    MAX_SEARCH_DEPTH, time_limits_fixed(seconds * 1000));
+        print_search_lines(lines, num_lines);
+        print_stats();
+        save_hash();
+        custom_memory_deinit();
+        hash_table_free();
+        return 0;
+    }
+
     touch_log_file();
+    set_search_info_output(true);
 
     pthread_t cli_thread, sdl_thread;
     pthread_create(&cli_thread, NULL, cli_game_loop, NULL);
@@ -76,11 +158,13 @@ void* cli_game_loop(void* arg)
     set_colour(&playing_as_white);
     write_log_pgn_header(playing_as_white);
     printf("\n");
+    hash_table_new_game();
     start_clock(); // Start the clock for the first player
 
     while (1) { if (!play_game(&position)) { break; /* Exit the game loop if game is over */ } }
 
     check_memory_leak();
+    save_hash();
     custom_memory_deinit();
     hash_table_free();
     return NULL;
@@ -99,8 +183,25 @@ bool play_game(Position_t* position)
         first_move = false;
     }
 
-    // user move
-    make_move_from_cli(position, &move_position);
+    // user move - the engine ponders on the expected reply meanwhile
+    bool pondering = ponder_start(position);
+    char move_notation[MOVE_LENGTH];
+    read_move_from_cli(move_notation);
+    while (run_cli_command(move_notation)) {
+        pondering = ponder_start(position);
+        read_move_from_cli(move_notation);
+    }
+
+    if (pondering) {
+        if (is_san_of_move(position, get_ponder_position(), move_notation)) {
+            return play_ponder_hit();
+        }
+        ponder_miss();
+    }
+
+    if (!make_move_from_san(position, &move_position, move_notation)) {
+        make_move_from_cli(position, &move_position);
+    }
     if (!update_game()) { return 0; /* Exit if the game is over */ }
 
     // engine move
@@ -112,6 +213,24 @@ bool play_game(Position_t* position)
     return 1;
 }
 
+// the user played the expected reply: the ponder search, already on it,
+// becomes the engine's move search
+bool play_ponder_hit(void)
+{
+    // position is already on the past move stack. The game end check has to
+    // wait for the search, as it generates moves
+    position = *get_ponder_position();
+    switch_time_decrement();
+    update_time_display();
+
+    ponder_hit(get_next_move_search_time(), &move_position);
+    print_stats();
+
+    if (is_game_ended(&position)) { return 0; }
+    if (!update_game()) { return 0; /* Exit if the game is over */ }
+    return 1;
+}
+
 bool update_game(void)
 {
     position = move_position;
@@ -122,16 +241,48 @@ bool update_game(void)
     return 1; // Game continues
 }
 
-void init(void)
+void init(size_t hash_mb)
 {
     gui_args.position = &position;
     gui_args.playing_as_white = &playing_as_white;
     custom_memory_init();
     move_finder_init();
     zobrist_key_init();
-    hash_table_init();
+    hash_table_init(hash_mb);
+    print_page_backing("Transposition table", transposition_table, hash_table_size_mb() << 20);
+    print_page_backing("Rook attack table", rook_attack_lookup_table,
+                       sizeof(rook_attack_lookup_table));
+    print_page_backing("Bishop attack table", bishop_attack_lookup_table,
+                       sizeof(bishop_attack_lookup_table));
     ui_init();
     fen_to_board(new, &position);
     insert_past_move_entry(&position);
 }
 
+void save_hash(void)
+{
+    if (save_hash_path) { hash_table_save(save_hash_path); }
+}
+
+// commands entered in place of a move, run while no search is:
+// hash <MB> - resize (and clear) the transposition table
+// clearhash - clear the transposition table
+bool run_cli_command(const char *input)
+{
+    size_t hash_mb;
+    if (sscanf(input, "hash %zu", &hash_mb) == 1) {
+        if (is_pondering()) { ponder_miss(); }
+        if (!hash_table_resize(hash_mb)) {
+            printf("Could not allocate a %zu MB transposition table\n", hash_mb);
+        }
+        printf("Transposition table: %zu MB\n", hash_table_size_mb());
+        return true;
+    }
+    if (strcmp(input, "clearhash") == 0) {
+        if (is_pondering()) { ponder_miss(); }
+        hash_table_clear();
+        printf("Transposition table cleared\n");
+        return true;
+    }
+    return false;
+}
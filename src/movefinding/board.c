@@ -55,6 +55,25 @@ int16_t calculate_piece_value_diff(Position_t *position)
     return piece_value_diff;
 }
 
+void move_to_string(Move_t move, char *move_string)
+{
+    static const char promotion_chars[] = {
+        [PIECE_KNIGHT] = 'n', [PIECE_BISHOP] = 'b',
+        [PIECE_ROOK] = 'r', [PIECE_QUEEN] = 'q',
+    };
+    const char *from = pretty_print_moves[get_move_from_square(move)];
+    const char *to = pretty_print_moves[get_move_to_square(move)];
+    uint8_t promotion = get_move_promotion(move);
+
+    move_string[0] = from[0];
+    move_string[1] = from[1];
+    move_string[2] = to[0];
+    move_string[3] = to[1];
+    move_string[4] = (promotion >= PIECE_KNIGHT && promotion <= PIECE_QUEEN)
+                   ? promotion_chars[promotion] : '\0';
+    move_string[5] = '\0';
+}
+
 void print_bitboard(uint64_t bitboard)
 {
     for (uint8_t i = 0; i < 64; i++)
@@ -139,8 +158,9 @@ void fen_to_board(char *fen, Position_t *fen_position)
 
     // ========================== HALF MOVE COUNT =========================
     i++; // skip space
-    uint8_t half_move_count = 0;
-    while (isdigit(fen[i])) { half_move_count = half_move_count * 10 + (fen[i++] - '0'); }
+    uint16_t half_move_clock = 0;
+    while (isdigit(fen[i])) { half_move_clock = half_move_clock * 10 + (fen[i++] - '0'); }
+    fen_position->half_move_clock = half_move_clock;
 
     // ========================= WHOLE MOVES =========================
     i++; // skip space
@@ -247,7 +267,7 @@ void board_to_fen(Position_t* position, char* fen)
     }
     // ========================== HALF MOVE COUNT =========================
     fen[fen_index++] = ' ';
-    fen_index += sprintf(&fen[fen_index], "%u", position->half_move_count);
+    fen_index += sprintf(&fen[fen_index], "%u", position->half_move_clock);
     // ========================= WHOLE MOVES =========================
     fen[fen_index++] = ' ';
     uint8_t whole_move_count = (position->half_move_count / 2) + 1;
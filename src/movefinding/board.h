@@ -25,6 +25,7 @@ extern const bool web_build;
 #endif
 
 #define MAX_CHILDREN 100
+#define MAX_PLY 128 // deepest line the search can reach, sizes the memory pool
 #define FEN_LENGTH 100
 #define MAXIMUM_GAME_LENGTH 512
 
@@ -76,7 +77,9 @@ typedef struct Position_t
     bool white_to_move;
     uint8_t from_sq;
     uint8_t to_sq;
+    uint8_t promotion;   // PieceType_t promoted to, 0 if none
     uint16_t half_move_count;
+    uint16_t half_move_clock;   // plies since the last capture or pawn move
     int32_t piece_value_diff;
     int32_t evaluation;
     ULL all_pieces;
@@ -125,6 +128,46 @@ typedef enum {
     PIECE_KING,
 } PieceType_t;
 
+/**
+ * @brief A move packed into 16 bits.
+ *
+ * Bits 0-5 hold the from square, bits 6-11 the to square and bits 12-15
+ * the PieceType_t promoted to (0 if none). NO_MOVE is never a legal move.
+ */
+typedef uint16_t Move_t;
+
+#define NO_MOVE 0
+#define MOVE_STRING_LENGTH 6
+
+static inline Move_t make_move(uint8_t from_square, uint8_t to_square, uint8_t promotion)
+{ return (Move_t)(from_square | (to_square << 6) | (promotion << 12)); }
+
+static inline uint8_t get_move_from_square(Move_t move)
+{ return move & 0x3F; }
+
+static inline uint8_t get_move_to_square(Move_t move)
+{ return (move >> 6) & 0x3F; }
+
+static inline uint8_t get_move_promotion(Move_t move)
+{ return move >> 12; }
+
+/**
+ * @brief Gets the move that led to a position made by move generation.
+ *
+ * @param position A child position from move_finder().
+ * @return The move from the parent to the position.
+ */
+static inline Move_t get_position_move(const Position_t *position)
+{ return make_move(position->from_sq, position->to_sq, position->promotion); }
+
+/**
+ * @brief Writes a move in long algebraic notation, e.g. "e2e4" or "e7e8q".
+ *
+ * @param move The move to be written.
+ * @param move_string Buffer of at least MOVE_STRING_LENGTH characters.
+ */
+void move_to_string(Move_t move, char *move_string);
+
 /**
  * @brief Prints the bitboard.
  *
@@ -19,6 +19,7 @@
 
 #include "lookuptables.h"
 #include "board.h"
+#include "memory.h"
 
 ULL rook_blocker_masks[64];
 ULL bishop_blocker_masks[64];
@@ -27,8 +28,9 @@ ULL castling_blocker_masks[2][3];
 ULL pawn_attack_lookup_table[2][64];
 ULL knight_attack_lookup_table[64];
 ULL king_attack_lookup_table[64];
-ULL rook_attack_lookup_table[64][4096];
-ULL bishop_attack_lookup_table[64][4096];
+// 2 MB each, aligned so each fills exactly one huge page
+ULL rook_attack_lookup_table[64][4096] __attribute__((aligned(HUGE_PAGE_SIZE)));
+ULL bishop_attack_lookup_table[64][4096] __attribute__((aligned(HUGE_PAGE_SIZE)));
 ULL magic_knight_attack_lookup_table[4096];
 
 ULL rook_castling_array[2][2];
@@ -1,8 +1,16 @@
 // memory.c
 
+// mmap, madvise and MAP_ANONYMOUS are not plain C17
+#define _DEFAULT_SOURCE
+
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
 #include "memory.h"
 #include "board.h"
@@ -41,3 +49,107 @@ void check_memory_leak(void)
         printf("---no-leaks-detected---\n");
     }
 }
+
+// ------------------------------------------------------------------
+// Large tables
+// ------------------------------------------------------------------
+
+static size_t round_to_huge_pages(size_t bytes)
+{ return (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1); }
+
+void huge_page_advise(void *memory, size_t bytes)
+{
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    // only the huge pages lying wholly inside the region
+    uintptr_t start = ((uintptr_t)memory + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+    uintptr_t end = ((uintptr_t)memory + bytes) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1);
+    if (end > start) { madvise((void *)start, end - start, MADV_HUGEPAGE); }
+#else
+    (void)memory;
+    (void)bytes;
+#endif
+}
+
+void *large_alloc(size_t bytes)
+{
+#ifdef __linux__
+    size_t rounded = round_to_huge_pages(bytes);
+    char *memory;
+
+#ifdef MAP_HUGETLB
+    // only succeeds when huge pages have been reserved (vm.nr_hugepages)
+    memory = mmap(NULL, rounded, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory != MAP_FAILED) { return memory; }
+#endif
+
+    // over-allocate by a huge page, then trim to a huge page boundary
+    size_t padded = rounded + HUGE_PAGE_SIZE;
+    char *raw = mmap(NULL, padded, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) { return NULL; }
+    memory = (char *)(((uintptr_t)raw + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+    if (memory > raw) { munmap(raw, (size_t)(memory - raw)); }
+    size_t tail = (size_t)((raw + padded) - (memory + rounded));
+    if (tail) { munmap(memory + rounded, tail); }
+
+    huge_page_advise(memory, rounded);
+    return memory;
+#else
+    size_t rounded = round_to_huge_pages(bytes);
+    void *memory = aligned_alloc(HUGE_PAGE_SIZE, rounded);
+    if (memory) { memset(memory, 0, rounded); }
+    return memory;
+#endif
+}
+
+void large_free(void *memory, size_t bytes)
+{
+    if (!memory) { return; }
+#ifdef __linux__
+    munmap(memory, round_to_huge_pages(bytes));
+#else
+    (void)bytes;
+    free(memory);
+#endif
+}
+
+size_t huge_page_backed_bytes(const void *memory, size_t bytes)
+{
+#ifdef __linux__
+    FILE *smaps = fopen("/proc/self/smaps", "r");
+    if (!smaps) { return 0; }
+
+    uintptr_t start = (uintptr_t)memory;
+    uintptr_t end = start + bytes;
+    bool overlaps = false;
+    size_t huge_kb = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), smaps)) {
+        unsigned long map_start, map_end, kb;
+        // a mapping's address range, followed by its fields
+        if (sscanf(line, "%lx-%lx ", &map_start, &map_end) == 2) {
+            overlaps = map_start < end && map_end > start;
+        } else if (overlaps
+                   && (sscanf(line, "AnonHugePages: %lu kB", &kb) == 1
+                       || sscanf(line, "Private_Hugetlb: %lu kB", &kb) == 1
+                       || sscanf(line, "Shared_Hugetlb: %lu kB", &kb) == 1)) {
+            huge_kb += kb;
+        }
+    }
+    fclose(smaps);
+
+    size_t huge_bytes = huge_kb << 10;
+    return huge_bytes < bytes ? huge_bytes : bytes;
+#else
+    (void)memory;
+    (void)bytes;
+    return 0;
+#endif
+}
+
+void print_page_backing(const char *name, const void *memory, size_t bytes)
+{
+    printf("%s: %zu MB, %zu MB in huge pages\n", name, bytes >> 20,
+           huge_page_backed_bytes(memory, bytes) >> 20);
+}
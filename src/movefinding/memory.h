@@ -4,7 +4,8 @@
 * @author Philip Brand
 * @date 2025-06-05
 *
-* Provides alternatives to malloc/free for memory allocation during movefinding.
+* Provides alternatives to malloc/free for memory allocation during movefinding,
+* and huge page backed allocation of the large tables.
 */
 
 #ifndef MEMORY_H
@@ -15,7 +16,10 @@
 
 #include "board.h"
 
-#define POOL_SIZE 1000 // Adjust size as needed
+// one full set of children for every ply the search can reach
+#define POOL_SIZE ((MAX_PLY + 2) * MAX_CHILDREN)
+
+#define HUGE_PAGE_SIZE ((size_t)2 << 20)
 
 extern Position_t *memory_pool[POOL_SIZE];
 extern size_t pool_index;
@@ -69,4 +73,50 @@ void custom_free_n(uint16_t n);
  */
 void check_memory_leak(void);
 
+// ------------------------------------------------------------------
+// Large tables
+// ------------------------------------------------------------------
+
+/**
+ * @brief Allocates zeroed memory for a large table, in huge pages where
+ * the system allows.
+ *
+ * Reserved 2 MB pages (MAP_HUGETLB) are tried first, then memory aligned
+ * to HUGE_PAGE_SIZE and advised to be backed by transparent huge pages.
+ *
+ * @param bytes The size of the table.
+ * @return The table, aligned to HUGE_PAGE_SIZE, or NULL on failure.
+ */
+void *large_alloc(size_t bytes);
+
+/**
+ * @brief Frees a table allocated by large_alloc().
+ *
+ * @param memory The table, or NULL.
+ * @param bytes The size it was allocated with.
+ */
+void large_free(void *memory, size_t bytes);
+
+/**
+ * @brief Asks for the whole huge pages of a region to be backed by
+ * transparent huge pages. Call before the region is first written.
+ */
+void huge_page_advise(void *memory, size_t bytes);
+
+/**
+ * @brief Gets how much of a region is currently backed by huge pages,
+ * from /proc/self/smaps.
+ *
+ * Counts whole mappings overlapping the region, so a region sharing a
+ * mapping can be over-reported, up to its own size.
+ *
+ * @return The bytes backed by huge pages, 0 where this cannot be read.
+ */
+size_t huge_page_backed_bytes(const void *memory, size_t bytes);
+
+/**
+ * @brief Prints the size of a table and how much of it is in huge pages.
+ */
+void print_page_backing(const char *name, const void *memory, size_t bytes);
+
 #endif // MEMORY_H
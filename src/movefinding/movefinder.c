@@ -34,6 +34,14 @@ static const int32_t attacker_values_array[14] = {
     [EN_PASSANT_CAPTURE] = PAWN_VALUE,
 };
 
+// PieceType_t promoted to, 0 for every other move
+static const uint8_t promotion_pieces_array[14] = {
+    [PROMOTE_QUEEN]    = PIECE_QUEEN,
+    [PROMOTE_ROOK]     = PIECE_ROOK,
+    [PROMOTE_BISHOP]   = PIECE_BISHOP,
+    [PROMOTE_KNIGHT]   = PIECE_KNIGHT,
+};
+
 void populate_position(MoveType_t piece,
                        Position_t *new_position,
                        uint8_t to_square,
@@ -56,6 +64,9 @@ uint64_t get_num_new_positions(void)
 
 void move_finder_init(void)
 {
+    // before the tables are first written, so they are faulted in as huge pages
+    huge_page_advise(rook_attack_lookup_table, sizeof(rook_attack_lookup_table));
+    huge_page_advise(bishop_attack_lookup_table, sizeof(bishop_attack_lookup_table));
     generate_lookup_tables();
     if (DEBUG && !web_build) { printf("---lookup-tables-generated---\n"); }
 }
@@ -585,6 +596,7 @@ void generate_new_positions(MoveType_t piece,
 
             new_position->from_sq = from_square;
             new_position->to_sq = to_square;
+            new_position->promotion = promotion_pieces_array[piece];
 
             // MVV-LVA score - captures are high, quiet moves are 0
             int32_t mvv_lva = victim_value * VICTIM_WEIGHTING - attacker_value;
@@ -622,6 +634,10 @@ void populate_position(MoveType_t piece,
     new_position->all_pieces |= to_square_bitboard;
     new_position->white_to_move = !WHITE_TO_MOVE;
     new_position->half_move_count++;
+    // the fifty-move clock restarts on pawn moves and captures
+    bool irreversible = (OLD_POSTION->pieces[WHITE_TO_MOVE].pawns & from_square_bitboard)
+                     || (OLD_POSTION->pieces[!WHITE_TO_MOVE].all_pieces & to_square_bitboard);
+    new_position->half_move_clock = irreversible ? 0 : OLD_POSTION->half_move_clock + 1;
     new_position->num_children = 0;
     new_position->en_passant_bitboard = 0;
     active_pieces_set->all_pieces ^= move_bitboard;
@@ -40,6 +40,35 @@ bool is_check(Position_t* position, bool for_white)
 }
 
 
+bool is_insufficient_material(const Position_t* position)
+{
+    const PiecesOneColour_t *white = &position->pieces[WHITE_INDEX];
+    const PiecesOneColour_t *black = &position->pieces[!WHITE_INDEX];
+    if (white->pawns | white->rooks | white->queens |
+        black->pawns | black->rooks | black->queens) { return false; }
+
+    ULL knights = white->knights | black->knights;
+    ULL bishops = white->bishops | black->bishops;
+    // a lone minor piece cannot mate
+    if (__builtin_popcountll(knights | bishops) <= 1) { return true; }
+    // nor can bishops that all stand on one colour
+    return !knights && (!(bishops & LIGHT_SQUARES) || !(bishops & DARK_SQUARES));
+}
+
+bool is_rule_draw(Position_t* position)
+{
+    if (is_insufficient_material(position)) { return true; }
+    if (position->half_move_clock < FIFTY_MOVE_RULE_PLIES) { return false; }
+    if (!is_check(position, position->white_to_move)) { return true; }
+
+    // in check: a draw unless it is checkmate
+    move_finder(position);
+    bool has_moves = position->num_children > 0;
+    free_children_memory(position);
+    clear_children_count(position);
+    return has_moves;
+}
+
 KingStatus_t determine_king_status(Position_t* position, bool for_white)
 {
     if (is_repetition(position, 3)) { return THREEFOLD_REPETITION; }
@@ -64,6 +93,8 @@ KingStatus_t determine_king_status(Position_t* position, bool for_white)
         if (is_check(position, for_white)) { return CHECKMATE; }
         else { return STALEMATE; }
     }
+    if (is_insufficient_material(position)) { return INSUFFICIENT_MATERIAL; }
+    if (position->half_move_clock >= FIFTY_MOVE_RULE_PLIES) { return FIFTY_MOVE_RULE; }
     if (is_check(position, for_white)) {
         return CHECK;
     }
@@ -35,17 +35,24 @@
 // Evaluation thresholds
 #define MID_GAME_MOVE_COUNT 15
 
+// Draw rules
+#define FIFTY_MOVE_RULE_PLIES 100
+
 // Masks
 #define CENTER_FOUR_SQUARES 0x0000001818000000
 #define BOX_SQUARES 0x00003C24243C0000
 #define NOT_EDGE_RANKS 0x00FFFFFFFFFFFF00
+#define LIGHT_SQUARES 0xAA55AA55AA55AA55
+#define DARK_SQUARES (~LIGHT_SQUARES)
 
 typedef enum {
     BORING,
     CHECK,
     CHECKMATE,
     STALEMATE,
-    THREEFOLD_REPETITION
+    THREEFOLD_REPETITION,
+    FIFTY_MOVE_RULE,
+    INSUFFICIENT_MATERIAL
 } KingStatus_t;
 
 /**
@@ -65,12 +72,37 @@ int32_t evaluate_position(Position_t* position);
  */
 bool is_check(Position_t* position, bool for_white);
 
+/**
+ * @brief Determines if neither side has the material left to checkmate.
+ *
+ * True for a lone minor piece against a bare king, and for positions with
+ * only bishops that all stand on squares of one colour.
+ *
+ * @param position The position to check
+ * @return true if the position is a dead draw, false otherwise
+ */
+bool is_insufficient_material(const Position_t* position);
+
+/**
+ * @brief Determines if the position is drawn by the fifty-move rule or by
+ * insufficient material.
+ *
+ * A checkmate on the move that completes the fifty moves still counts, so
+ * moves are generated when the side to move is in check with the
+ * fifty-move clock run out.
+ *
+ * @param position The position to check
+ * @return true if the position is drawn, false otherwise
+ */
+bool is_rule_draw(Position_t* position);
+
 /**
  * @brief Determines the status of the king in the position.
  *
  * @param position The position to check
  * @param for_white true to check the white king, false for black king
- * @return The status of the king (CHECK, CHECKMATE, STALEMATE, or BORING)
+ * @return The status of the king (CHECK, CHECKMATE, STALEMATE, a draw by
+ * rule, or BORING)
  */
 KingStatus_t determine_king_status(Position_t* position, bool for_white);
 
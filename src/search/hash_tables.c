@@ -1,33 +1,62 @@
 // transposition_table.c
 
+// sysconf and mmap are POSIX, not plain C17
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
-#include <time.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "../movefinding/board.h"
+#include "../movefinding/lookuptables.h"
 #include "hash_tables.h"
+#include "../movefinding/memory.h"
 
 ULL zobrist_key_table[2][6][64];
 ULL zobrist_black_to_move;
 ULL zobrist_en_passant[65];
 ULL zobrist_castling[2][2];
 
-TranspositionEntry_t *transposition_table = NULL;
+TranspositionBucket_t *transposition_table = NULL;
+ULL tt_mask = 0;
+uint8_t tt_generation = 0;
+#if TT_STATS
+TTStats_t tt_stats;
+#endif
+#if TT_NEAR_ROOT
+TranspositionBucket_t near_root_table[TT_NEAR_ROOT_BUCKETS];
+#endif
+
+// set while the table is a mapped file, see hash_table_load()
+static void *tt_mapping = NULL;
+static size_t tt_mapping_bytes = 0;
 
 ULL past_move_stack[
-    MAXIMUM_GAME_LENGTH + MAX_SEARCH_DEPTH + MAX_QUIESCENCE_DEPTH];
+    MAXIMUM_GAME_LENGTH + MAX_PLY + 1];
 int past_move_stack_top = 0;
 
-ULL random_64_bit(void)
+/*
+ * Cuckoo tables of every reversible move of a knight, bishop, rook, queen
+ * or king on an empty board, keyed by the Zobrist difference the move
+ * makes. cuckoo_path holds the squares that must be empty for it.
+ */
+static ULL cuckoo_keys[CUCKOO_SIZE];
+static ULL cuckoo_path[CUCKOO_SIZE];
+
+// splitmix64 from a fixed seed, so the keys are the same on every run
+static ULL random_64_bit(void)
 {
-    // set unique seed:
-    static bool seeded = false;
-    if (!seeded) {
-        srand((unsigned int)time(NULL));
-        seeded = true;
-    }
-    return ((ULL)rand() << 33) | ((ULL)rand() << 2) | (rand() & 3);
+    static ULL state = ZOBRIST_SEED;
+    ULL z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
 }
 
 void zobrist_key_init(void)
@@ -52,6 +81,88 @@ void zobrist_key_init(void)
     }
 
     zobrist_black_to_move = random_64_bit();
+
+    cuckoo_init();
+}
+
+static inline uint16_t cuckoo_h1(ULL key)
+{ return key & (CUCKOO_SIZE - 1); }
+
+static inline uint16_t cuckoo_h2(ULL key)
+{ return (key >> 16) & (CUCKOO_SIZE - 1); }
+
+// squares strictly between two squares on a line, 0 if not on a line
+static ULL squares_between(int from, int to)
+{
+    int from_rank = from / 8, from_file = from % 8;
+    int to_rank = to / 8, to_file = to % 8;
+    int rank_step = (to_rank > from_rank) - (to_rank < from_rank);
+    int file_step = (to_file > from_file) - (to_file < from_file);
+
+    bool on_line = from_rank == to_rank || from_file == to_file
+        || abs(to_rank - from_rank) == abs(to_file - from_file);
+    if (!on_line) { return 0; }
+
+    ULL between = 0;
+    int rank = from_rank + rank_step, file = from_file + file_step;
+    while (rank != to_rank || file != to_file) {
+        between |= 1ULL << (8 * rank + file);
+        rank += rank_step;
+        file += file_step;
+    }
+    return between;
+}
+
+static bool reaches_on_empty_board(PieceType_t piece, int from, int to)
+{
+    int rank_diff = abs(to / 8 - from / 8);
+    int file_diff = abs(to % 8 - from % 8);
+    bool straight = rank_diff == 0 || file_diff == 0;
+    bool diagonal = rank_diff == file_diff;
+
+    switch (piece) {
+        case PIECE_KNIGHT: return knight_attack_lookup_table[from] & (1ULL << to);
+        case PIECE_KING:   return king_attack_lookup_table[from] & (1ULL << to);
+        case PIECE_BISHOP: return diagonal;
+        case PIECE_ROOK:   return straight;
+        case PIECE_QUEEN:  return straight || diagonal;
+        default:           return false;
+    }
+}
+
+void cuckoo_init(void)
+{
+    memset(cuckoo_keys, 0, sizeof(cuckoo_keys));
+    memset(cuckoo_path, 0, sizeof(cuckoo_path));
+
+    for (int colour = 0; colour < 2; colour++) {
+        for (PieceType_t piece = PIECE_KNIGHT; piece <= PIECE_KING; piece++) {
+            for (int from = 0; from < 64; from++) {
+                for (int to = from + 1; to < 64; to++) {
+                    if (!reaches_on_empty_board(piece, from, to)) { continue; }
+
+                    ULL key = zobrist_key_table[colour][piece][from]
+                            ^ zobrist_key_table[colour][piece][to]
+                            ^ zobrist_black_to_move;
+                    ULL path = squares_between(from, to);
+
+                    // cuckoo insertion: an evicted entry moves to its other slot
+                    uint16_t slot = cuckoo_h1(key);
+                    while (true) {
+                        ULL evicted_key = cuckoo_keys[slot];
+                        ULL evicted_path = cuckoo_path[slot];
+                        cuckoo_keys[slot] = key;
+                        cuckoo_path[slot] = path;
+                        if (evicted_key == 0) { break; }
+
+                        key = evicted_key;
+                        path = evicted_path;
+                        slot = (slot == cuckoo_h1(key)) ? cuckoo_h2(key) : cuckoo_h1(key);
+                    }
+                }
+            }
+        }
+    }
 }
 
 ULL generate_zobrist_hash(Position_t *position)
@@ -107,23 +218,300 @@ ULL generate_zobrist_hash(Position_t *position)
 
 bool is_repetition(Position_t* position, uint8_t rept)
 {
+    // only positions with the same side to move and after the last capture
+    // or pawn move can repeat this one
     ULL key = position->zobrist_key;
-    for (int i = past_move_stack_top - 1; i >= 0; i--) {
+    int top = past_move_stack_top - 1;
+    int end = top - position->half_move_clock;
+    if (end < 0) { end = 0; }
+
+    for (int i = top; i >= end; i -= 2) {
         if (past_move_stack[i] == key && --rept == 0) return true;
-        if ((i+1) < rept) break;
     }
     return false;
 }
 
-void hash_table_init(void) 
+bool has_upcoming_repetition(Position_t* position, uint8_t ply)
+{
+    // positions an odd number of plies back have the other side to move,
+    // so one move by the side to move could turn them into this one
+    ULL key = position->zobrist_key;
+    int top = past_move_stack_top - 1;
+    int end = (int)ply - 1;
+    if (position->half_move_clock < end) { end = position->half_move_clock; }
+
+    for (int i = 3; i <= end; i += 2) {
+        ULL move_key = key ^ past_move_stack[top - i];
+        uint16_t slot = cuckoo_h1(move_key);
+        if (cuckoo_keys[slot] != move_key) {
+            slot = cuckoo_h2(move_key);
+            if (cuckoo_keys[slot] != move_key) { continue; }
+        }
+        if (!(cuckoo_path[slot] & position->all_pieces)) { return true; }
+    }
+    return false;
+}
+
+// largest power of two number of buckets that fits in size_mb
+static size_t tt_buckets_for(size_t size_mb)
+{
+    size_t bytes = size_mb << 20;
+    size_t buckets = 1;
+    while (buckets * 2 * sizeof(TranspositionBucket_t) <= bytes) { buckets *= 2; }
+    return buckets;
+}
+
+bool hash_table_resize(size_t size_mb)
+{
+    if (size_mb < MIN_HASH_MB) { size_mb = MIN_HASH_MB; }
+    if (size_mb > MAX_HASH_MB) { size_mb = MAX_HASH_MB; }
+
+    size_t min_buckets = tt_buckets_for(MIN_HASH_MB);
+    size_t requested_buckets = tt_buckets_for(size_mb);
+    size_t buckets = requested_buckets;
+    // huge page aligned, so no bucket straddles two cache lines. The old
+    // table is only freed once this succeeds, so a failure leaves it usable
+    TranspositionBucket_t *table;
+    while (!(table = large_alloc(buckets * sizeof(TranspositionBucket_t)))) {
+        if (buckets <= min_buckets) { return false; }
+        buckets /= 2;
+    }
+    hash_table_free();
+    transposition_table = table;
+    tt_mask = buckets - 1;
+    hash_table_clear();
+
+    if (buckets < requested_buckets) {
+        fprintf(stderr, "Could not allocate a %zu MB transposition table, using %zu MB\n",
+                size_mb, hash_table_size_mb());
+    }
+    return true;
+}
+
+size_t hash_table_size_mb(void)
+{
+    if (!transposition_table) { return 0; }
+    return ((size_t)tt_mask + 1) * sizeof(TranspositionBucket_t) >> 20;
+}
+
+void hash_table_new_search(void)
+{ tt_generation = (tt_generation + 1) & TT_GENERATION_MASK; }
+
+void hash_table_new_game(void)
+{ tt_generation = (tt_generation + TT_NEW_GAME_GENERATIONS) & TT_GENERATION_MASK; }
+
+uint16_t hash_table_hashfull(void)
+{
+    if (!transposition_table) { return 0; }
+
+    size_t buckets = TT_HASHFULL_SAMPLE / TT_BUCKET_SIZE;
+    if (buckets > (size_t)tt_mask + 1) { buckets = (size_t)tt_mask + 1; }
+    size_t used = 0;
+    for (size_t i = 0; i < buckets; i++) {
+        for (int j = 0; j < TT_BUCKET_SIZE; j++) {
+            TranspositionData_t data =
+                tt_unpack(tt_load_word(&transposition_table[i].entries[j].data));
+            used += data.generation_bound && tt_data_age(&data) == 0;
+        }
+    }
+    return (uint16_t)(used * 1000 / (buckets * TT_BUCKET_SIZE));
+}
+
+typedef struct {
+    char *start;
+    size_t bytes;
+} ClearChunk_t;
+
+static void *clear_chunk(void *arg)
+{
+    ClearChunk_t *chunk = arg;
+    memset(chunk->start, 0, chunk->bytes);
+    return NULL;
+}
+
+void hash_table_clear(void)
 {
-    transposition_table = calloc(1, sizeof(TranspositionEntry_t) * TT_SIZE);
-    if (!transposition_table) {
+    if (!transposition_table) { return; }
+
+    size_t bytes = ((size_t)tt_mask + 1) * sizeof(TranspositionBucket_t);
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t num_threads = cpus > 1 ? (size_t)cpus : 1;
+    if (num_threads > TT_CLEAR_MAX_THREADS) { num_threads = TT_CLEAR_MAX_THREADS; }
+    // not worth starting threads for a small table
+    size_t max_useful = bytes / ((size_t)TT_CLEAR_MIN_CHUNK_MB << 20);
+    if (num_threads > max_useful) { num_threads = max_useful ? max_useful : 1; }
+
+    // chunks of whole buckets, the last one takes the remainder
+    pthread_t threads[TT_CLEAR_MAX_THREADS];
+    bool started[TT_CLEAR_MAX_THREADS] = {false};
+    ClearChunk_t chunks[TT_CLEAR_MAX_THREADS];
+    size_t chunk_bytes = bytes / num_threads / sizeof(TranspositionBucket_t)
+                       * sizeof(TranspositionBucket_t);
+    for (size_t i = 0; i < num_threads; i++) {
+        chunks[i].start = (char *)transposition_table + i * chunk_bytes;
+        chunks[i].bytes = (i == num_threads - 1) ? bytes - i * chunk_bytes : chunk_bytes;
+        if (i > 0) {
+            started[i] = pthread_create(&threads[i], NULL, clear_chunk, &chunks[i]) == 0;
+        }
+    }
+
+    // this thread clears the first chunk, and any a thread failed to start for
+    for (size_t i = 0; i < num_threads; i++) {
+        if (!started[i]) { clear_chunk(&chunks[i]); }
+    }
+    for (size_t i = 1; i < num_threads; i++) {
+        if (started[i]) { pthread_join(threads[i], NULL); }
+    }
+
+#if TT_NEAR_ROOT
+    memset(near_root_table, 0, sizeof(near_root_table));
+#endif
+    tt_generation = 0;
+}
+
+void hash_table_init(size_t size_mb)
+{
+    if (!hash_table_resize(size_mb)) {
         fprintf(stderr, "Failed to allocate transposition table\n");
         exit(1);
     }
 }
 
 void hash_table_free(void)
-{ free(transposition_table); }
+{
+    if (tt_mapping) {
+        munmap(tt_mapping, tt_mapping_bytes);
+        tt_mapping = NULL;
+    } else {
+        large_free(transposition_table, ((size_t)tt_mask + 1) * sizeof(TranspositionBucket_t));
+    }
+    transposition_table = NULL;
+    tt_mask = 0;
+}
+
+// ------------------------------------------------------------------
+// Saving and loading
+// ------------------------------------------------------------------
+
+// folds every Zobrist key, so a table saved with other keys is rejected
+static ULL zobrist_fingerprint(void)
+{
+    ULL hash = 0xCBF29CE484222325ULL;
+    const ULL *keys[] = {
+        &zobrist_key_table[0][0][0], zobrist_en_passant, &zobrist_castling[0][0],
+        &zobrist_black_to_move
+    };
+    const size_t counts[] = {
+        sizeof(zobrist_key_table) / sizeof(ULL), sizeof(zobrist_en_passant) / sizeof(ULL),
+        sizeof(zobrist_castling) / sizeof(ULL), 1
+    };
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        for (size_t j = 0; j < counts[i]; j++) {
+            hash = (hash ^ keys[i][j]) * 0x100000001B3ULL;
+        }
+    }
+    return hash;
+}
+
+static TTFileHeader_t tt_file_header(void)
+{
+    TTFileHeader_t header = {
+        .magic = TT_FILE_MAGIC,
+        .version = TT_FILE_VERSION,
+        .entry_size = sizeof(TranspositionEntry_t),
+        .bucket_size = TT_BUCKET_SIZE,
+        .generation = tt_generation,
+        .num_buckets = tt_mask + 1,
+        .zobrist_fingerprint = zobrist_fingerprint(),
+    };
+    return header;
+}
+
+bool hash_table_save(const char *path)
+{
+    if (!transposition_table) { return false; }
+
+    // written beside the target and renamed over it: the target may be the
+    // file the table is mapped from, which must not be truncated under it
+    size_t tmp_length = strlen(path) + sizeof(TT_FILE_TMP_SUFFIX);
+    char *tmp_path = malloc(tmp_length);
+    if (!tmp_path) { return false; }
+    snprintf(tmp_path, tmp_length, "%s" TT_FILE_TMP_SUFFIX, path);
+
+    FILE *file = fopen(tmp_path, "wb");
+    if (!file) {
+        fprintf(stderr, "Could not open %s to save the transposition table\n", tmp_path);
+        free(tmp_path);
+        return false;
+    }
+
+    // the table starts a page into the file, so it can be mapped in place
+    char header_page[TT_FILE_HEADER_BYTES] = {0};
+    TTFileHeader_t header = tt_file_header();
+    memcpy(header_page, &header, sizeof(header));
+    size_t bytes = ((size_t)tt_mask + 1) * sizeof(TranspositionBucket_t);
+    bool success = fwrite(header_page, sizeof(header_page), 1, file) == 1
+                && fwrite(transposition_table, bytes, 1, file) == 1;
+    success = (fclose(file) == 0) && success;
+    success = success && rename(tmp_path, path) == 0;
+
+    if (!success) {
+        fprintf(stderr, "Could not write the transposition table to %s\n", path);
+        remove(tmp_path);
+    }
+    free(tmp_path);
+    return success;
+}
+
+bool hash_table_load(const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Could not open transposition table file %s\n", path);
+        return false;
+    }
+
+    TTFileHeader_t header;
+    TTFileHeader_t expected = tt_file_header();
+    struct stat file_stat;
+    const char *problem = NULL;
+    if (pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)
+        || memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0) {
+        problem = "is not a transposition table file";
+    } else if (header.version != expected.version
+               || header.entry_size != expected.entry_size
+               || header.bucket_size != expected.bucket_size) {
+        problem = "has another entry format";
+    } else if (header.zobrist_fingerprint != expected.zobrist_fingerprint) {
+        problem = "was saved with other Zobrist keys";
+    } else if (header.num_buckets == 0 || (header.num_buckets & (header.num_buckets - 1))
+               || fstat(fd, &file_stat) != 0
+               || (ULL)file_stat.st_size != TT_FILE_HEADER_BYTES
+                      + header.num_buckets * sizeof(TranspositionBucket_t)) {
+        problem = "has the wrong size";
+    }
+    if (problem) {
+        fprintf(stderr, "Transposition table file %s %s\n", path, problem);
+        close(fd);
+        return false;
+    }
+
+    // private mapping: pages are read when first probed, and stores stay
+    // in memory instead of going back to the file
+    size_t bytes = (size_t)file_stat.st_size;
+    void *mapping = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        fprintf(stderr, "Could not map transposition table file %s\n", path);
+        return false;
+    }
+
+    hash_table_free();
+    tt_mapping = mapping;
+    tt_mapping_bytes = bytes;
+    transposition_table = (TranspositionBucket_t *)((char *)mapping + TT_FILE_HEADER_BYTES);
+    tt_mask = header.num_buckets - 1;
+    tt_generation = (uint8_t)(header.generation & TT_GENERATION_MASK);
+    return true;
+}
 
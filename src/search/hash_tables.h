@@ -9,13 +9,22 @@
 #define TRANSPOSITION_TABLE_H
 
 #include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
 
 #include "../movefinding/board.h"
 #include "search.h"
 
-#define TT_SIZE_BITS 28
-#define TT_SIZE (1ULL << TT_SIZE_BITS)
-#define TT_MASK (TT_SIZE - 1)
+// transposition table size in MB, rounded down to a power of two entries
+#define DEFAULT_HASH_MB 256
+#define MIN_HASH_MB 1
+#define MAX_HASH_MB 65536
+
+// power of two, with room for the 3668 reversible piece moves
+#define CUCKOO_SIZE 8192
+
+// seed of the Zobrist keys; changing it invalidates saved tables
+#define ZOBRIST_SEED 0x54455353ULL
 
 extern ULL zobrist_key_table[2][6][64];
 extern ULL zobrist_black_to_move;
@@ -28,19 +37,122 @@ typedef enum {
     UPPER_BOUND
 } NodeType_t;
 
+/**
+ * @brief A 16 byte transposition table entry.
+ *
+ * The search result is packed into the data word and the key word holds
+ * the Zobrist key XOR the data. Both words are written and read without
+ * locks, so a thread may see the key of one store and the data of
+ * another; the XOR then no longer gives the probed key and the entry is
+ * ignored, instead of handing out another position's score.
+ */
 typedef struct {
-    ULL zobrist_key;
-    ULL best_move_zobrist_key;
-    int32_t position_evaluation;
-    uint16_t half_move_count;
-    uint8_t search_depth;
-    NodeType_t node_type;
+    _Atomic ULL key;    // Zobrist key ^ data
+    _Atomic ULL data;   // move | eval << 16 | depth << 48 | generation_bound << 56
 } TranspositionEntry_t;
 
-extern TranspositionEntry_t *transposition_table;
+/**
+ * @brief A search result as read from the transposition table.
+ */
+typedef struct {
+    Move_t move;            // best move, NO_MOVE if none was found
+    int32_t eval;           // mate scores relative to the node
+    uint8_t depth;
+    uint8_t generation_bound;   // generation << 2 | (NodeType_t + 1), 0 if empty
+} TranspositionData_t;
+
+// fetch a child's bucket when it is picked for searching, ahead of its
+// probe (off by default, it lowered bench NPS where measured)
+#ifndef TT_PREFETCH
+#define TT_PREFETCH 0
+#endif
+
+// count probes, hits, cutoffs and stores in tt_stats (off by default,
+// the counters cost a little on every node)
+#ifndef TT_STATS
+#define TT_STATS 0
+#endif
+
+// one bucket per cache line
+#define TT_BUCKET_SIZE 4
+#define TT_ALIGNMENT 64
+#define TT_GENERATION_MASK 0x3F
+// a stored result of the same position is kept unless the new one is
+// exact, from a newer search, or at most this much shallower
+#define TT_REPLACE_DEPTH_MARGIN 4
+// replacement score of an entry: depth - TT_AGE_WEIGHT * searches since stored
+#define TT_AGE_WEIGHT 4
+// a new game ages the table by this many searches, instead of clearing it
+#define TT_NEW_GAME_GENERATIONS 8
+// hash_table_clear() splits the table between up to this many threads,
+// each clearing at least TT_CLEAR_MIN_CHUNK_MB
+#define TT_CLEAR_MAX_THREADS 16
+#define TT_CLEAR_MIN_CHUNK_MB 64
+// entries of the first buckets sampled for hash_table_hashfull()
+#define TT_HASHFULL_SAMPLE 1000
+
+// a small table of deep results, probed before the main table so the
+// nodes near the root mostly hit cache (off by default)
+#ifndef TT_NEAR_ROOT
+#define TT_NEAR_ROOT 0
+#endif
+#define TT_NEAR_ROOT_KB 1024     // about an L2 cache
+#define TT_NEAR_ROOT_BUCKETS (((size_t)TT_NEAR_ROOT_KB << 10) / TT_ALIGNMENT)
+#define TT_NEAR_ROOT_MIN_DEPTH 3
+
+// saved table file: a header page, then the buckets as they are in memory
+#define TT_FILE_MAGIC "TESSMXTT"
+#define TT_FILE_VERSION 1
+#define TT_FILE_HEADER_BYTES 4096
+#define TT_FILE_TMP_SUFFIX ".tmp"
+
+typedef struct __attribute__((aligned(TT_ALIGNMENT))) {
+    TranspositionEntry_t entries[TT_BUCKET_SIZE];
+} TranspositionBucket_t;
+
+extern TranspositionBucket_t *transposition_table;
+extern ULL tt_mask;     // number of buckets - 1
+extern uint8_t tt_generation;
+#if TT_NEAR_ROOT
+extern TranspositionBucket_t near_root_table[TT_NEAR_ROOT_BUCKETS];
+#endif
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_size;
+    uint32_t bucket_size;
+    uint32_t generation;
+    ULL num_buckets;
+    ULL zobrist_fingerprint;    // of every Zobrist key
+} TTFileHeader_t;
+
+/**
+ * @brief Transposition table counters since the start of the search.
+ * Not atomic, so only exact while a single thread searches.
+ */
+typedef struct {
+    ULL probes;
+    ULL hits;
+    ULL usable_hits;        // deep enough for the node's depth
+    ULL cutoffs[3];         // by NodeType_t of the entry
+    ULL stores;
+    ULL updates;            // same position stored again
+    ULL replacements;       // another position's entry overwritten
+    ULL near_root_probes;
+    ULL near_root_hits;
+    ULL near_root_stores;
+} TTStats_t;
+
+#if TT_STATS
+extern TTStats_t tt_stats;
+#define TT_STAT(statement) do { statement; } while (0)
+#else
+#define TT_STAT(statement) ((void)0)
+#endif
 
 extern ULL past_move_stack[
-    MAXIMUM_GAME_LENGTH + MAX_SEARCH_DEPTH + MAX_QUIESCENCE_DEPTH];
+    MAXIMUM_GAME_LENGTH + MAX_PLY + 1];
 extern int past_move_stack_top;
 
 typedef struct
@@ -55,16 +167,281 @@ typedef struct
  */
 void zobrist_key_init(void);
 
+/**
+ * @brief Builds the cuckoo tables used by has_upcoming_repetition().
+ *
+ * Called by zobrist_key_init(), as the tables depend on the Zobrist keys.
+ */
+void cuckoo_init(void);
+
 /**
  * @brief Initialises the hash tables for transposition and past move list.
+ *
+ * Exits if not even a MIN_HASH_MB table can be allocated.
+ *
+ * @param size_mb The transposition table size in MB, see hash_table_resize().
  */
-void hash_table_init(void);
+void hash_table_init(size_t size_mb);
+
+/**
+ * @brief Reallocates the transposition table, clearing it.
+ *
+ * The size is clamped to MIN_HASH_MB..MAX_HASH_MB and rounded down to a
+ * power of two number of entries. If the allocation fails, half the size
+ * is tried until MIN_HASH_MB. If even that fails, the old table is kept
+ * as it was. Must not be called while a search runs.
+ *
+ * @param size_mb The requested size in MB.
+ * @return true if a table was allocated, false if the process is out of memory.
+ */
+bool hash_table_resize(size_t size_mb);
+
+/**
+ * @brief Gets the size of the allocated transposition table.
+ *
+ * @return The size in MB.
+ */
+size_t hash_table_size_mb(void);
 
 /**
  * @brief Frees the memory allocated for the transposition table and past move list.
  */
 void hash_table_free(void);
 
+/**
+ * @brief Writes the transposition table to a file.
+ *
+ * The file is written under a temporary name and renamed over path, so
+ * a table loaded from path can be saved back to it.
+ *
+ * @param path The file to be written.
+ * @return Whether the whole table was written.
+ */
+bool hash_table_save(const char *path);
+
+/**
+ * @brief Replaces the transposition table with one saved by
+ * hash_table_save(), taking on its size.
+ *
+ * The file is mapped rather than read, so only the buckets probed are
+ * loaded. Files of another entry format, or saved with other Zobrist
+ * keys, are rejected and the current table is kept.
+ *
+ * @param path The file to be loaded.
+ * @return Whether the table was loaded.
+ */
+bool hash_table_load(const char *path);
+
+/**
+ * @brief Starts a new search generation, so entries stored by earlier
+ * searches are replaced first.
+ */
+void hash_table_new_search(void);
+
+/**
+ * @brief Starts a new game or analysis. The earlier entries stay usable
+ * but are replaced before any stored from now on, without touching the
+ * table's memory.
+ */
+void hash_table_new_game(void);
+
+/**
+ * @brief Zeroes the transposition table, split between several threads.
+ * Must not run alongside a search.
+ */
+void hash_table_clear(void);
+
+/**
+ * @brief Samples how full the table is with entries of the current search.
+ *
+ * @return Per mille of the first TT_HASHFULL_SAMPLE entries in use.
+ */
+uint16_t hash_table_hashfull(void);
+
+static inline ULL tt_pack(const TranspositionData_t *data)
+{
+    return (ULL)data->move | (ULL)(uint32_t)data->eval << 16
+         | (ULL)data->depth << 48 | (ULL)data->generation_bound << 56;
+}
+
+static inline TranspositionData_t tt_unpack(ULL data)
+{
+    return (TranspositionData_t){
+        .move = (Move_t)data,
+        .eval = (int32_t)(uint32_t)(data >> 16),
+        .depth = (uint8_t)(data >> 48),
+        .generation_bound = (uint8_t)(data >> 56),
+    };
+}
+
+// relaxed: each word is read or written whole, the XOR checks the pair
+static inline ULL tt_load_word(const _Atomic ULL *word)
+{ return atomic_load_explicit(word, memory_order_relaxed); }
+
+static inline void tt_store_word(_Atomic ULL *word, ULL value)
+{ atomic_store_explicit(word, value, memory_order_relaxed); }
+
+static inline void tt_prefetch(ULL key)
+{
+#if TT_PREFETCH
+    __builtin_prefetch(&transposition_table[key & tt_mask]);
+#else
+    (void)key;
+#endif
+}
+
+static inline NodeType_t tt_data_bound(const TranspositionData_t *data)
+{ return (NodeType_t)((data->generation_bound & 3) - 1); }
+
+static inline uint8_t tt_data_age(const TranspositionData_t *data)
+{ return (tt_generation - (data->generation_bound >> 2)) & TT_GENERATION_MASK; }
+
+// finds key in one bucket, see tt_probe()
+static inline bool tt_bucket_probe(const TranspositionBucket_t *bucket, ULL key,
+                                   TranspositionData_t *data)
+{
+    const TranspositionEntry_t *entries = bucket->entries;
+    for (int i = 0; i < TT_BUCKET_SIZE; i++) {
+        ULL word = tt_load_word(&entries[i].data);
+        if ((tt_load_word(&entries[i].key) ^ word) == key && (word >> 56)) {
+            *data = tt_unpack(word);
+            return true;
+        }
+    }
+    return false;
+}
+
+typedef enum {
+    TT_STORED_EMPTY,        // into an empty entry
+    TT_STORED_UPDATE,       // over the same position
+    TT_STORED_REPLACE       // over another position
+} TTStoreResult_t;
+
+// stores into one bucket, see tt_store()
+static inline TTStoreResult_t tt_bucket_store(TranspositionBucket_t *bucket, ULL key,
+                                              int32_t eval, uint8_t depth,
+                                              NodeType_t bound, Move_t move)
+{
+    TranspositionEntry_t *entries = bucket->entries;
+
+    TranspositionEntry_t *replace = &entries[0];
+    TranspositionData_t old = tt_unpack(tt_load_word(&entries[0].data));
+    int replace_score = INT32_MAX;
+    bool same_position = false;
+    for (int i = 0; i < TT_BUCKET_SIZE; i++) {
+        ULL word = tt_load_word(&entries[i].data);
+        TranspositionData_t stored = tt_unpack(word);
+        if (!stored.generation_bound || (tt_load_word(&entries[i].key) ^ word) == key) {
+            replace = &entries[i];
+            old = stored;
+            same_position = stored.generation_bound != 0;
+            break;
+        }
+        int score = stored.depth - TT_AGE_WEIGHT * tt_data_age(&stored);
+        if (score < replace_score) {
+            replace = &entries[i];
+            old = stored;
+            replace_score = score;
+        }
+    }
+
+    TranspositionData_t data = {
+        .move = move, .eval = eval, .depth = depth,
+        .generation_bound = (uint8_t)((tt_generation << 2) | (bound + 1)),
+    };
+    if (same_position) {
+        if (move == NO_MOVE) { data.move = old.move; }
+        if (bound != EXACT && tt_data_age(&old) == 0
+            && depth + TT_REPLACE_DEPTH_MARGIN <= old.depth) {
+            data = old;
+            data.move = move == NO_MOVE ? old.move : move;
+        }
+    }
+
+    ULL word = tt_pack(&data);
+    tt_store_word(&replace->data, word);
+    tt_store_word(&replace->key, key ^ word);
+
+    if (same_position) { return TT_STORED_UPDATE; }
+    return old.generation_bound ? TT_STORED_REPLACE : TT_STORED_EMPTY;
+}
+
+#if TT_NEAR_ROOT
+static inline TranspositionBucket_t *tt_near_root_bucket(ULL key)
+{ return &near_root_table[key & (TT_NEAR_ROOT_BUCKETS - 1)]; }
+#endif
+
+/**
+ * @brief Looks up a position in the transposition table.
+ *
+ * With TT_NEAR_ROOT set, nodes of at least TT_NEAR_ROOT_MIN_DEPTH look in
+ * the near-root table first. Safe to call while other threads store to
+ * the table.
+ *
+ * @param key The Zobrist key of the position.
+ * @param depth The depth the node is searched to.
+ * @param data Set to the stored result if the position is found.
+ * @return Whether the position was found.
+ */
+static inline bool tt_probe(ULL key, uint8_t depth, TranspositionData_t *data)
+{
+#if TT_NEAR_ROOT
+    if (depth >= TT_NEAR_ROOT_MIN_DEPTH) {
+        TT_STAT(tt_stats.near_root_probes++);
+        if (tt_bucket_probe(tt_near_root_bucket(key), key, data)) {
+            TT_STAT(tt_stats.near_root_hits++);
+            return true;
+        }
+    }
+#else
+    (void)depth;
+#endif
+
+    TT_STAT(tt_stats.probes++);
+    if (tt_bucket_probe(&transposition_table[key & tt_mask], key, data)) {
+        TT_STAT(tt_stats.hits++);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Stores a search result in the transposition table.
+ *
+ * An entry of the same position is updated in place. Otherwise the entry
+ * of the bucket with the lowest depth, less TT_AGE_WEIGHT per search since
+ * it was stored, is replaced. With TT_NEAR_ROOT set, results of at least
+ * TT_NEAR_ROOT_MIN_DEPTH are stored in the near-root table as well. Safe
+ * to call while other threads probe or store to the table; a store racing
+ * another may be lost, never mixed.
+ *
+ * @param key The Zobrist key of the position.
+ * @param eval The score, with mate scores relative to the node.
+ * @param depth The depth searched.
+ * @param bound Whether eval is exact or a bound.
+ * @param move The best move, or NO_MOVE to keep the stored one.
+ */
+static inline void tt_store(ULL key, int32_t eval, uint8_t depth,
+                            NodeType_t bound, Move_t move)
+{
+#if TT_NEAR_ROOT
+    if (depth >= TT_NEAR_ROOT_MIN_DEPTH) {
+        tt_bucket_store(tt_near_root_bucket(key), key, eval, depth, bound, move);
+        TT_STAT(tt_stats.near_root_stores++);
+    }
+#endif
+
+    TTStoreResult_t result = tt_bucket_store(&transposition_table[key & tt_mask],
+                                             key, eval, depth, bound, move);
+#if TT_STATS
+    tt_stats.stores++;
+    if (result == TT_STORED_UPDATE) { tt_stats.updates++; }
+    else if (result == TT_STORED_REPLACE) { tt_stats.replacements++; }
+#else
+    (void)result;
+#endif
+}
+
 /**
  * @brief Generates a Zobrist hash for the given position.
  *
@@ -84,12 +461,30 @@ static inline void clear_past_move_entry(void)
 { past_move_stack_top--; }
 
 /**
- * @brief Checks if the given position has occurred at least three times.
- * 
+ * @brief Checks if the given position has occurred rept times.
+ *
+ * The position must be on top of the past move stack. Only every second
+ * entry back to the last capture or pawn move is compared.
+ *
  * @param position The position to check.
- * @return true if the position has occurred at least three times, false otherwise.
+ * @param rept The number of occurrences, including this one.
+ * @return true if the position has occurred at least rept times, false otherwise.
 */
 bool is_repetition(Position_t* position, uint8_t rept);
 
+/**
+ * @brief Checks if the side to move has a move that repeats a position
+ * from the current search line.
+ *
+ * Uses the cuckoo tables of reversible moves, so no moves are generated.
+ * Only positions fewer than ply plies back, i.e. inside the search tree,
+ * are considered.
+ *
+ * @param position The position to check, on top of the past move stack.
+ * @param ply The distance from the search root.
+ * @return true if a move leads to a repetition.
+*/
+bool has_upcoming_repetition(Position_t* position, uint8_t ply);
+
 #endif // TRANSPOSITION_TABLE_H
 
@@ -0,0 +1,94 @@
+/**
+ * @file movepicker.h
+ * @brief Picks the children of a position in move ordering order
+ * @author Philip Brand
+ * @date 2026-10-19
+ *
+ * The ordering scores are copied once into a dense array of
+ * (child index, score) pairs, and the next best child is found by a
+ * selection over that array. A child position is only loaded when it is
+ * about to be searched, instead of on every comparison.
+ */
+
+#ifndef MOVEPICKER_H
+#define MOVEPICKER_H
+
+#include <stdint.h>
+
+#include "../movefinding/board.h"
+
+#define KILLER_EVALUATION 90
+
+typedef struct {
+    uint8_t index;      // into child_positions
+    int32_t score;
+} ScoredMove_t;
+
+/**
+ * @brief Ordering state of the children of one node.
+ */
+typedef struct {
+    ScoredMove_t moves[MAX_CHILDREN];
+    uint16_t num_moves;
+    uint16_t next;
+    uint16_t sort_start;    // moves before this are returned unsorted
+} MovePicker_t;
+
+/**
+ * @brief Scores the children of position for move_picker_next().
+ *
+ * Children before sort_start (a TT or PV move already placed first) are
+ * returned in their current order, the rest by MVV-LVA evaluation. Quiet
+ * moves matching one of the killers are scored just below the captures.
+ *
+ * @param picker The picker to be initialised.
+ * @param position The position whose children are picked.
+ * @param sort_start Number of leading children not to be sorted.
+ * @param killers The two killer moves of the ply, or NULL for none.
+ */
+static inline void move_picker_init(MovePicker_t *picker, const Position_t *position,
+                                    uint16_t sort_start, const Move_t *killers)
+{
+    picker->num_moves = position->num_children;
+    picker->next = 0;
+    picker->sort_start = sort_start;
+
+    for (uint16_t i = 0; i < position->num_children; i++) {
+        picker->moves[i].index = (uint8_t)i;
+        if (i < sort_start) { continue; }
+
+        const Position_t *child = position->child_positions[i];
+        int32_t score = child->evaluation;
+        if (killers && score <= KILLER_EVALUATION) {
+            Move_t move = get_position_move(child);
+            if (move == killers[0]) { score = KILLER_EVALUATION; }
+            else if (move == killers[1]) { score = KILLER_EVALUATION - 10; }
+        }
+        picker->moves[i].score = score;
+    }
+}
+
+/**
+ * @brief Gets the next best child to be searched.
+ *
+ * @param picker A picker set up by move_picker_init().
+ * @return The index of the child in child_positions.
+ */
+static inline uint16_t move_picker_next(MovePicker_t *picker)
+{
+    uint16_t i = picker->next++;
+    if (i < picker->sort_start) { return picker->moves[i].index; }
+
+    uint16_t best = i;
+    for (uint16_t j = i + 1; j < picker->num_moves; j++) {
+        if (picker->moves[j].score > picker->moves[best].score) { best = j; }
+    }
+    if (best != i) {
+        ScoredMove_t tmp = picker->moves[i];
+        picker->moves[i] = picker->moves[best];
+        picker->moves[best] = tmp;
+    }
+    return picker->moves[i].index;
+}
+
+#endif // MOVEPICKER_H
@@ -0,0 +1,117 @@
+// ponder.c
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "ponder.h"
+#include "search.h"
+#include "hash_tables.h"
+#include "timeman.h"
+#include "../movefinding/movefinder.h"
+#include "../movefinding/memory.h"
+
+static pthread_t ponder_thread;
+static bool pondering = false;
+static bool info_output = false;     // search info output to restore
+static atomic_bool ponder_search_done = false;
+
+static Position_t ponder_position;   // position after the expected reply
+static Position_t ponder_root;       // the search's own copy of it
+static Position_t ponder_best_move;  // engine's answer to the expected reply
+static int32_t ponder_eval = 0;
+
+static void* ponder_loop(void* arg)
+{
+    (void)arg; // Unused parameter
+    ponder_eval = find_best_move(&ponder_root, &ponder_best_move,
+                                 MAX_SEARCH_DEPTH, time_limits_infinite());
+    atomic_store(&ponder_search_done, true);
+    return NULL;
+}
+
+// expected reply: the child matching the TT best move of the position
+static bool find_expected_reply(Position_t *position, Position_t *reply)
+{
+    const ULL key = position->zobrist_key;
+    TranspositionData_t entry;
+    if (!tt_probe(key, 0, &entry) || entry.move == NO_MOVE) { return false; }
+
+    bool found = false;
+    move_finder(position);
+    for (uint16_t i = 0; i < position->num_children; i++) {
+        if (get_position_move(position->child_positions[i]) == entry.move) {
+            *reply = *position->child_positions[i];
+            found = true;
+            break;
+        }
+    }
+    free_children_memory(position);
+    if (!found) { return false; }
+
+    // nothing to ponder on if the reply ends the game
+    move_finder(reply);
+    uint16_t num_replies = reply->num_children;
+    free_children_memory(reply);
+    return num_replies > 0;
+}
+
+bool ponder_start(Position_t *position)
+{
+    if (pondering) { ponder_miss(); }
+    if (!find_expected_reply(position, &ponder_position)) { return false; }
+
+    ponder_root = ponder_position;
+    insert_past_move_entry(&ponder_position);
+    atomic_store(&ponder_search_done, false);
+
+    // the opponent is typing, keep the ponder search quiet
+    info_output = get_search_info_output();
+    set_search_info_output(false);
+
+    if (pthread_create(&ponder_thread, NULL, ponder_loop, NULL) != 0) {
+        set_search_info_output(info_output);
+        clear_past_move_entry();
+        return false;
+    }
+    pondering = true;
+    return true;
+}
+
+bool is_pondering(void)
+{ return pondering; }
+
+Position_t* get_ponder_position(void)
+{ return &ponder_position; }
+
+int32_t ponder_hit(TimeLimits_t limits, Position_t *return_best_move)
+{
+    // the search may not have started its clock yet if the reply came
+    // straight away, and it may already have ended by reaching max depth
+    while (!time_manager_set_limits(limits) && !atomic_load(&ponder_search_done)) {
+        sched_yield();
+    }
+    pthread_join(ponder_thread, NULL);
+    pondering = false;
+    set_search_info_output(info_output);
+
+    *return_best_move = ponder_best_move;
+    return ponder_eval;
+}
+
+void ponder_miss(void)
+{
+    // a stop requested before the search started its clock would be
+    // cleared by it, so keep asking until the search has ended
+    while (!atomic_load(&ponder_search_done)) {
+        time_manager_stop_search();
+        sched_yield();
+    }
+    pthread_join(ponder_thread, NULL);
+    pondering = false;
+    set_search_info_output(info_output);
+
+    clear_past_move_entry();
+}
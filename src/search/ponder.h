@@ -0,0 +1,75 @@
+/**
+ * @file ponder.h
+ * @brief Searching on the opponent's time
+ * @author Philip Brand
+ * @date 2026-10-19
+ *
+ * After the engine moves, the reply it expects (the best move stored in the
+ * transposition table) is searched in a background thread with no time
+ * limit while the opponent thinks.
+ * - ponder hit: the opponent played the expected move, the running search
+ *   keeps its iterations and is given the engine's time for the move
+ * - ponder miss: the search is stopped, only its TT entries are kept
+ *
+ * Move generation, the memory pool and the past move stack are not thread
+ * safe, so the game thread must not touch them between ponder_start() and
+ * ponder_hit() / ponder_miss().
+ */
+
+#ifndef PONDER_H
+#define PONDER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../movefinding/board.h"
+#include "timeman.h"
+
+/**
+ * @brief Starts pondering on the expected reply to the engine's move.
+ *
+ * The expected reply is pushed onto the past move stack for the search.
+ *
+ * @param position The position after the engine's move.
+ * @return true if a ponder search was started, false if there is no
+ * expected reply to search.
+ */
+bool ponder_start(Position_t *position);
+
+/**
+ * @brief Checks whether a ponder search is running or waiting for a result.
+ *
+ * @return true between ponder_start() and ponder_hit() / ponder_miss().
+ */
+bool is_pondering(void);
+
+/**
+ * @brief Gets the reply the ponder search is searching.
+ *
+ * The search works on its own copy, so this one can be read while it runs.
+ *
+ * @return The position after the expected reply.
+ */
+Position_t* get_ponder_position(void);
+
+/**
+ * @brief Turns the ponder search into the search for the engine's move.
+ *
+ * Blocks until the search is finished. The expected reply stays on the
+ * past move stack.
+ *
+ * @param limits The time limits for the engine's move, counted from now.
+ * @param return_best_move Set to the position after the engine's best move.
+ * @return The evaluation of the best move.
+ */
+int32_t ponder_hit(TimeLimits_t limits, Position_t *return_best_move);
+
+/**
+ * @brief Stops the ponder search after the opponent played another move.
+ *
+ * Blocks until the search has stopped and removes the expected reply from
+ * the past move stack.
+ */
+void ponder_miss(void);
+
+#endif // PONDER_H
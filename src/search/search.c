@@ -8,36 +8,17 @@
 #include "search.h"
 #include "evaluate.h"
 #include "hash_tables.h"
+#include "timeman.h"
 #include "../movefinding/board.h"
 #include "../movefinding/movefinder.h"
 
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #define MIN(a, b) ((a) < (b) ? (a) : (b))
 
-typedef struct {
-    uint8_t from_sq;
-    uint8_t to_sq;
-} Killer_t;
-
-static Killer_t killer_moves[MAX_SEARCH_DEPTH][2];
-
-static int32_t best_eval = 0;
-static int32_t prev_eval = 0;
-static uint8_t searched_depth = 0;
-static uint8_t completed_depth = 0;
-
-static clock_t start_time = 0;
-static clock_t global_max_time = 0;
-static bool time_up = false;
-
-static ULL nodes_analysed = 0;
-static uint32_t aspiration_attempts = 0;
-static uint32_t aspiration_failures = 0;
-static uint32_t beta_count = 0;
-static uint32_t beta_first_move_count = 0;
-static uint64_t total_moves_before_cutoff = 0;
-static ULL interior_nodes = 0;
+// state of the search run by find_best_move / find_best_moves
+static SearchThread_t main_thread;
 
+static bool search_info_output = false;
 
 /*
  * Unified negamax.
@@ -56,13 +37,36 @@ static ULL interior_nodes = 0;
  *   - move_finder() is called here.
  *   - Full TT behaviour (lookup + store).
  *   - free_children_memory() is called before every return path.
+ *
+ * ply is the distance from the root. It is tracked separately from depth
+ * because extensions mean thread->searched_depth - depth is no longer the ply.
  */
-static int32_t negamax(Position_t *position, uint8_t depth,
+static int32_t negamax(SearchThread_t *thread, Position_t *position,
+                       uint8_t depth, uint8_t ply,
                        int32_t alpha, int32_t beta,
                        Position_t *return_best_move);
 
-static int32_t quiescence(Position_t *position, int32_t alpha, int32_t beta,
-                          uint8_t qdepth);
+static int32_t quiescence(SearchThread_t *thread, Position_t *position,
+                          int32_t alpha, int32_t beta, uint8_t ply);
+
+/*
+ * Mate scores are relative to the root (-CHECKMATE_VALUE + ply), but a TT
+ * entry can be probed from any ply. They are stored relative to the node
+ * instead and converted back on probe.
+ */
+static inline int32_t value_to_tt(int32_t value, uint8_t ply)
+{
+    if (value > MATE_THRESHOLD && value <= CHECKMATE_VALUE) { return value + ply; }
+    if (value < -MATE_THRESHOLD && value >= -CHECKMATE_VALUE) { return value - ply; }
+    return value;
+}
+
+static inline int32_t value_from_tt(int32_t value, uint8_t ply)
+{
+    if (value > MATE_THRESHOLD && value <= CHECKMATE_VALUE + MAX_PLY) { return value - ply; }
+    if (value < -MATE_THRESHOLD && value >= -CHECKMATE_VALUE - MAX_PLY) { return value + ply; }
+    return value;
+}
 
 static inline int compare_positions_desc(const void *a, const void *b)
 {
@@ -81,154 +85,377 @@ static inline void sort_children(Position_t *position)
     clear_grandchildren_count(position);
 }
 
+// the timer thread raises the stop flag at the hard deadline, so polling
+// it is a single relaxed load and can be done at every node
 static inline bool time_is_up(void)
+{ return search_stop_requested(); }
+
+/*
+ * Called after each fully completed depth: tracks how long the best move
+ * has been stable and how far the score moved, for the time manager.
+ */
+static inline void record_iteration(SearchThread_t *thread,
+                                    const Position_t *best_move,
+                                    int32_t eval, int32_t last_eval)
 {
-    if ((nodes_analysed & 4095) != 0) { return false; }  // check every 4096 nodes
-    time_up = (clock() - start_time) >= global_max_time;
-    return time_up;
+    if (best_move->zobrist_key == thread->last_best_move_key) {
+        if (thread->best_move_stability < UINT8_MAX) { thread->best_move_stability++; }
+    } else {
+        thread->best_move_stability = 0;
+        thread->last_best_move_key = best_move->zobrist_key;
+    }
+    thread->score_drop = last_eval - eval;
 }
 
+static inline bool stop_iterating(const SearchThread_t *thread)
+{
+    return time_manager_hard_stop()
+        || time_manager_soft_stop(thread->best_move_stability, thread->score_drop,
+                                  thread->best_move_effort);
+}
 
-int32_t find_best_move(Position_t *position,
-                       Position_t *return_best_move,
-                       uint8_t max_depth,
-                       long long max_time)
+// ------------------------------------------------------------------------
+// Root move ordering
+// ------------------------------------------------------------------------
+
+static void init_root_moves(SearchThread_t *thread, Position_t *position)
 {
-    start_time = clock();
-    global_max_time = max_time * CLOCKS_PER_SEC / 1000;
-    best_eval = 0;
-    prev_eval = 0;
-    completed_depth = 0;
-    searched_depth = 1;
-
-    nodes_analysed = 0;
-    interior_nodes = 0;
-    aspiration_attempts = 0;
-    aspiration_failures  = 0;
-    beta_count = 0;
-    beta_first_move_count = 0;
-    total_moves_before_cutoff = 0;
-
-    memset(killer_moves, 0, sizeof(killer_moves));
+    thread->num_root_moves = position->num_children;
+    for (uint16_t i = 0; i < position->num_children; i++) {
+        thread->root_moves[i] = (RootMove_t){position->child_positions[i], 0, 0};
+    }
+}
 
-    move_finder(position);
+static inline RootMove_t *find_root_move(SearchThread_t *thread,
+                                         const Position_t *child)
+{
+    for (uint16_t i = 0; i < thread->num_root_moves; i++) {
+        if (thread->root_moves[i].position == child) { return &thread->root_moves[i]; }
+    }
+    return NULL;
+}
 
-    Position_t saved_best_move = *position;
+static inline bool root_move_before(const RootMove_t *a, const RootMove_t *b,
+                                    Move_t best_move)
+{
+    bool a_is_best = get_position_move(a->position) == best_move;
+    bool b_is_best = get_position_move(b->position) == best_move;
+    if (a_is_best != b_is_best) { return a_is_best; }
+    return a->previous_nodes > b->previous_nodes;
+}
 
-    /* ------------------------------------------------------------------ */
-    /* Full-window iterative deepening for the first few plies             */
-    /* ------------------------------------------------------------------ */
-    while (!time_is_up()
-           && searched_depth < FULL_ASPIRATION_WINDOW_DEPTH
-           && searched_depth <= max_depth)
-    {
-        sort_children(position);
-        int32_t eval = negamax(position, searched_depth,
-                               -INT32_MAX, INT32_MAX, return_best_move);
-        if (eval == RAN_OUT_OF_TIME) { break; }
-        saved_best_move = *return_best_move;
-        best_eval = eval;
-        prev_eval = eval;
-        completed_depth = searched_depth;   /* this depth finished cleanly */
-        searched_depth++;
+/*
+ * The scores returned for root moves other than the best are mostly
+ * fail-low bounds, so they say little about which move comes next. The
+ * root is searched best move first, then by the nodes each move took in
+ * the previous iteration. The sort is stable: ties keep their old order.
+ */
+static void order_root_moves(SearchThread_t *thread, Position_t *position,
+                             Move_t best_move)
+{
+    RootMove_t *moves = thread->root_moves;
+    for (uint16_t i = 1; i < thread->num_root_moves; i++) {
+        RootMove_t move = moves[i];
+        uint16_t j = i;
+        while (j > 0 && root_move_before(&move, &moves[j - 1], best_move)) {
+            moves[j] = moves[j - 1];
+            j--;
+        }
+        moves[j] = move;
     }
 
-    /* ------------------------------------------------------------------ */
-    /* Aspiration window search                                            */
-    /* ------------------------------------------------------------------ */
-    while (!time_is_up() && searched_depth <= max_depth)
-    {
-        sort_children(position);
+    for (uint16_t i = 0; i < thread->num_root_moves; i++) {
+        position->child_positions[i] = moves[i].position;
+    }
+    clear_grandchildren_count(position);
+}
+
+// share of the iteration's nodes, in percent, spent below best_move
+static uint8_t root_move_effort(const SearchThread_t *thread,
+                                const Position_t *best_move)
+{
+    ULL total = 0;
+    ULL best = 0;
+    for (uint16_t i = 0; i < thread->num_root_moves; i++) {
+        const RootMove_t *move = &thread->root_moves[i];
+        total += move->nodes;
+        if (move->position->zobrist_key == best_move->zobrist_key) { best = move->nodes; }
+    }
+    return total > 0 ? (uint8_t)(best * 100 / total) : 0;
+}
+
+/*
+ * Root moves already found in the current iteration of a MultiPV search
+ * are skipped, so the next search of the root finds the next best.
+ */
+static inline bool is_excluded_root_move(const SearchThread_t *thread,
+                                         const Position_t *child)
+{
+    for (uint16_t i = 0; i < thread->num_excluded_root_moves; i++) {
+        if (thread->excluded_root_moves[i] == child->zobrist_key) { return true; }
+    }
+    return false;
+}
 
-        int32_t alpha = prev_eval - ASPIRATION_WINDOW;
-        int32_t beta  = prev_eval + ASPIRATION_WINDOW;
-        int32_t eval;
-        bool depth_failed = false;   /* did this depth need a retry? */
-        aspiration_attempts++;       /* one attempt per depth */
+static inline void update_pv(SearchThread_t *thread, uint8_t ply, Move_t move)
+{
+    uint8_t child_length = thread->pv_length[ply + 1];
+    thread->pv_table[ply][0] = move;
+    memcpy(&thread->pv_table[ply][1], thread->pv_table[ply + 1],
+           child_length * sizeof(Move_t));
+    thread->pv_length[ply] = child_length + 1;
+}
 
-        while (1) {
-            eval = negamax(position, searched_depth, alpha, beta, return_best_move);
+static void print_search_info(const SearchThread_t *thread,
+                              const SearchLine_t *line, uint8_t line_number)
+{
+    long long time = time_manager_elapsed();
+    ULL nps = thread->stats.nodes * 1000ULL / (ULL)MAX(time, 1);
+
+    printf("info depth %u multipv %u score ", line->depth, line_number);
+    if (line->score > MATE_THRESHOLD) {
+        printf("mate %d", (CHECKMATE_VALUE - line->score + 1) / 2);
+    } else if (line->score < -MATE_THRESHOLD) {
+        printf("mate -%d", (CHECKMATE_VALUE + line->score) / 2);
+    } else {
+        printf("cp %d", line->score);
+    }
+    printf(" nodes %llu nps %llu hashfull %u time %lld pv",
+           thread->stats.nodes, nps, hash_table_hashfull(), time);
 
-            if (eval == RAN_OUT_OF_TIME) { break; } /* check timeout first */
+    char move_string[MOVE_STRING_LENGTH];
+    for (uint8_t i = 0; i < line->pv_length; i++) {
+        move_to_string(line->pv[i], move_string);
+        printf(" %s", move_string);
+    }
+    printf("\n");
+    fflush(stdout);
+}
 
-            // Mate score detected — no point widening further
-            if (eval > CHECKMATE_VALUE - 1000 || eval < -CHECKMATE_VALUE + 1000) {
-                best_eval = eval;
-                prev_eval = eval;
-                saved_best_move = *return_best_move;
-                completed_depth = searched_depth;
-                break;
-            }
+/*
+ * Searches the root at thread->searched_depth. From FULL_ASPIRATION_WINDOW_DEPTH
+ * on, the window is centred on last_eval, sized by how much the score
+ * has been moving, and widened on the failing side only.
+ */
+static int32_t aspiration_search(SearchThread_t *thread,
+                                 Position_t *position, int32_t last_eval,
+                                 Position_t *return_best_move)
+{
+    if (thread->searched_depth < FULL_ASPIRATION_WINDOW_DEPTH) {
+        thread->follow_pv = true;
+        return negamax(thread, position, thread->searched_depth, 0,
+                       -INT32_MAX, INT32_MAX, return_best_move);
+    }
 
-            if (eval <= alpha) {
-                depth_failed = true;
-                alpha -= 5 * ASPIRATION_WINDOW;
+    int32_t delta = ASPIRATION_MIN_WINDOW + thread->score_volatility;
+    int32_t alpha = last_eval - delta;
+    int32_t beta  = last_eval + delta;
+    int32_t eval;
+    bool depth_failed = false;   /* did this depth need a retry? */
+    thread->stats.aspiration_attempts++;   /* one attempt per depth */
 
-            } else if (eval >= beta) {
-                depth_failed = true;
-                beta += 5 * ASPIRATION_WINDOW;
+    while (1) {
+        thread->follow_pv = true;
+        eval = negamax(thread, position, thread->searched_depth, 0,
+                       alpha, beta, return_best_move);
 
-            } else {
-                // Fully inside window — commit
-                best_eval = eval;
-                saved_best_move = *return_best_move;
-                completed_depth = searched_depth;
-                break;
-            }
+        if (eval == RAN_OUT_OF_TIME) { break; } /* check timeout first */
 
-            /* fall back to full-width if window is huge,
-             * or if we saw a positive mate (fail-high) */
-            if (alpha < -12000 || beta > 12000 ||
-                (eval > CHECKMATE_VALUE - 1000 && eval >= beta)) {
-                eval = negamax(position, searched_depth,
-                               -INT32_MAX, INT32_MAX, return_best_move);
-                if (eval != RAN_OUT_OF_TIME) {
-                    best_eval = eval;
-                    saved_best_move = *return_best_move;
-                    prev_eval = eval;
-                    completed_depth = searched_depth;
-                }
-                break;
-            }
+        // Mate score detected — no point widening further
+        if (eval > MATE_THRESHOLD || eval < -MATE_THRESHOLD) { break; }
+
+        if (eval > alpha && eval < beta) { break; } // inside window — commit
 
+        depth_failed = true;
+        delta += delta / 2;
+        if (eval <= alpha) {
+            thread->stats.aspiration_fail_lows++;
+            alpha = (delta > ASPIRATION_MAX_WINDOW) ? -INT32_MAX : eval - delta;
+        } else {
+            thread->stats.aspiration_fail_highs++;
+            beta = (delta > ASPIRATION_MAX_WINDOW) ? INT32_MAX : eval + delta;
         }
+    }
 
-        if (depth_failed) { aspiration_failures++; }  // one failure per depth
+    if (depth_failed) { thread->stats.aspiration_failures++; }  // one failure per depth
+    return eval;
+}
 
-        prev_eval = best_eval;
-        searched_depth++;
+/*
+ * One iteration of iterative deepening at thread->searched_depth: the root is
+ * searched once per line, excluding the moves found for earlier lines.
+ * lines and return_best_move are only updated if every line finished.
+ */
+static bool search_iteration(SearchThread_t *thread,
+                             Position_t *position, SearchLine_t *lines,
+                             uint8_t num_lines, Position_t *return_best_move)
+{
+    Position_t best_move, first_move;
+
+    for (uint16_t i = 0; i < thread->num_root_moves; i++) {
+        thread->root_moves[i].previous_nodes = thread->root_moves[i].nodes;
+        thread->root_moves[i].nodes = 0;
+    }
+
+    thread->num_excluded_root_moves = 0;
+    for (uint8_t k = 0; k < num_lines; k++) {
+        order_root_moves(thread, position,
+                         lines[k].pv_length > 0 ? lines[k].pv[0] : NO_MOVE);
+        memcpy(thread->followed_pv, lines[k].pv,
+               lines[k].pv_length * sizeof(Move_t));
+        thread->followed_pv_length = lines[k].pv_length;
+
+        int32_t eval = aspiration_search(thread, position, lines[k].score, &best_move);
+        if (eval == RAN_OUT_OF_TIME) { return false; }
+
+        SearchLine_t *line = &thread->iteration_lines[k];
+        line->score = eval;
+        line->depth = thread->searched_depth;
+        line->pv_length = MIN(thread->pv_length[0], MAX_PV_LENGTH);
+        memcpy(line->pv, thread->pv_table[0], line->pv_length * sizeof(Move_t));
+        // a root search that failed low leaves no PV behind
+        if (line->pv_length == 0 || line->pv[0] != get_position_move(&best_move)) {
+            line->pv[0] = get_position_move(&best_move);
+            line->pv_length = 1;
+        }
+
+        thread->excluded_root_moves[thread->num_excluded_root_moves++] =
+            best_move.zobrist_key;
+        if (k == 0) { first_move = best_move; }
+    }
+    thread->num_excluded_root_moves = 0;
+
+    memcpy(lines, thread->iteration_lines, num_lines * sizeof(SearchLine_t));
+    *return_best_move = first_move;
+
+    if (search_info_output) {
+        for (uint8_t k = 0; k < num_lines; k++) {
+            print_search_info(thread, &lines[k], k + 1);
+        }
+    }
+    return true;
+}
+
+/*
+ * Iterative deepening driver shared by find_best_move (one line) and
+ * find_best_moves (MultiPV). Children of position are freed on return.
+ */
+static uint8_t search_root(SearchThread_t *thread,
+                           Position_t *position, SearchLine_t *lines,
+                           uint8_t num_lines, uint8_t max_depth,
+                           TimeLimits_t limits, Position_t *return_best_move)
+{
+    time_manager_start(limits);
+    hash_table_new_search();
+    thread->best_move_stability = 0;
+    thread->last_best_move_key = 0;
+    thread->score_drop = 0;
+    thread->best_move_effort = 0;
+    thread->score_volatility = ASPIRATION_INITIAL_VOLATILITY;
+    thread->best_eval = 0;
+    thread->prev_eval = 0;
+    thread->completed_depth = 0;
+    thread->searched_depth = 1;
+
+    memset(&thread->stats, 0, sizeof(thread->stats));
+#if TT_STATS
+    memset(&tt_stats, 0, sizeof(tt_stats));
+#endif
+    memset(thread->stack, 0, sizeof(thread->stack));
+    thread->followed_pv_length = 0;
+
+    move_finder(position);
+    sort_children(position);
+    init_root_moves(thread, position);
+    num_lines = MIN(num_lines, position->num_children);
+    memset(lines, 0, num_lines * sizeof(SearchLine_t));
+
+    *return_best_move = *position;
+
+    while (num_lines > 0 && !stop_iterating(thread)
+           && thread->searched_depth <= max_depth)
+    {
+        if (!search_iteration(thread, position, lines, num_lines,
+                              return_best_move)) { break; }
+
+        thread->best_eval = lines[0].score;
+        if (thread->completed_depth > 0) {
+            int32_t change = abs(thread->best_eval - thread->prev_eval);
+            thread->score_volatility = (3 * thread->score_volatility
+                                        + MIN(change, ASPIRATION_MAX_WINDOW)) / 4;
+        }
+        thread->completed_depth = thread->searched_depth;   /* this depth finished cleanly */
+        record_iteration(thread, return_best_move, thread->best_eval, thread->prev_eval);
+        thread->best_move_effort = root_move_effort(thread, return_best_move);
+        thread->prev_eval = thread->best_eval;
+        thread->searched_depth++;
     }
 
-    *return_best_move = saved_best_move;
+    // joins the timer thread and clears the stop flag, so the fallback
+    // search below is not cut short as well
+    time_manager_finish();
 
-    if (completed_depth == 0) {
-        negamax(position, 1, -INT32_MAX, INT32_MAX, return_best_move);
+    if (thread->completed_depth == 0 && num_lines > 0) {
+        thread->searched_depth = 1;
+        search_iteration(thread, position, lines, num_lines, return_best_move);
         struct timespec ts = {0, 50 * 1000000};
         nanosleep(&ts, NULL);
     }
 
     free_children_memory(position);
 
-    return best_eval;
+    return num_lines;
 }
 
-static int32_t negamax(Position_t *position, uint8_t depth,
+int32_t find_best_move(Position_t *position,
+                       Position_t *return_best_move,
+                       uint8_t max_depth,
+                       TimeLimits_t limits)
+{
+    SearchLine_t line;
+    search_root(&main_thread, position, &line, 1, max_depth, limits, return_best_move);
+    return main_thread.best_eval;
+}
+
+uint8_t find_best_moves(Position_t *position,
+                        SearchLine_t *lines,
+                        uint8_t num_lines,
+                        uint8_t max_depth,
+                        TimeLimits_t limits)
+{
+    Position_t best_move;
+    return search_root(&main_thread, position, lines, num_lines, max_depth,
+                       limits, &best_move);
+}
+
+static int32_t negamax(SearchThread_t *thread, Position_t *position,
+                       uint8_t depth, uint8_t ply,
                        int32_t alpha, int32_t beta,
                        Position_t *return_best_move)
 {
     const bool is_root = (return_best_move != NULL);
 
-    if (depth > 0 && !is_root) { interior_nodes++; }
-    nodes_analysed++;
+    if (depth > 0 && !is_root) { thread->stats.interior_nodes++; }
+    thread->stats.nodes++;
+    thread->pv_length[ply] = 0;
+
+    // only the previous PV's first child is searched with follow_pv set
+    const bool on_pv = thread->follow_pv && ply < thread->followed_pv_length;
+    thread->follow_pv = false;
 
     /* ------------------------------------------------------------------ */
     /* Base case — hand off to quiescence search instead of evaluating    */
     /* statically, so captures beyond the horizon are not missed.         */
+    /* The ply cap keeps extended lines inside the memory pool.            */
     /* ------------------------------------------------------------------ */
-    if (depth == 0) {
-        return quiescence(position, alpha, beta, MAX_QUIESCENCE_DEPTH);
+    if (depth == 0 || ply >= MAX_PLY) {
+        return quiescence(thread, position, alpha, beta, ply);
     }
 
+    // interior nodes are not statically evaluated
+    SearchStack_t *ss = &thread->stack[ply];
+    ss->static_eval = EVAL_NONE;
+
     // ------------------------------------------------------------------
     // Threefold-repetition draw (skip at root — root position is already
     // in the past-move list; we don't want an instant draw evaluation)
@@ -237,36 +464,74 @@ static int32_t negamax(Position_t *position, uint8_t depth,
         return 0;
     }
 
+    // fifty-move rule and dead drawn material
+    if (!is_root && is_rule_draw(position)) {
+        return 0;
+    }
+
+    // ------------------------------------------------------------------
+    // Upcoming repetition: if a reversible move repeats a position of the
+    // current line, the side to move can hold at least a draw
+    // ------------------------------------------------------------------
+    if (!is_root && alpha < 0 && has_upcoming_repetition(position, ply)) {
+        alpha = 0;
+        if (alpha >= beta) { return alpha; }
+    }
+
+    // ------------------------------------------------------------------
+    // Mate distance pruning: nothing below this node can be better than
+    // mating next move, or worse than being mated right here
+    // ------------------------------------------------------------------
+    if (!is_root) {
+        alpha = MAX(alpha, -CHECKMATE_VALUE + ply);
+        beta  = MIN(beta, CHECKMATE_VALUE - ply - 1);
+        if (alpha >= beta) { return alpha; }
+    }
+
     // -------------------------------------------------------------
     // Transposition table
     // ---------------------------------------------------------------
     const ULL key = position->zobrist_key;
-    TranspositionEntry_t *entry = &transposition_table[key & TT_MASK];
+    TranspositionData_t entry;
+    bool tt_hit = tt_probe(key, depth, &entry);
     bool tt_move_found = false;
     int32_t orig_alpha = alpha;
 
-    ULL entry_key = entry->zobrist_key;
-    if (entry_key == key) {
-        tt_move_found = true;
+    // copied out: the singular verification search may overwrite the slot
+    int32_t tt_eval = 0;
+    uint8_t tt_depth = 0;
+    NodeType_t tt_node_type = UPPER_BOUND;
+    Move_t tt_move = NO_MOVE;
+
+    if (tt_hit) {
+        tt_eval = value_from_tt(entry.eval, ply);
+        tt_depth = entry.depth;
+        tt_node_type = tt_data_bound(&entry);
+        tt_move = entry.move;
+        // quiescence entries carry no move
+        tt_move_found = tt_move != NO_MOVE;
         /*
-         * At the root we use the TT only for move ordering.
-         * Applying alpha/beta cutoffs here would suppress the best-move
-         * output even when the TT score is stale from a narrower window.
+         * No cutoffs at the root: they would suppress the best-move output
+         * even when the TT score is stale from a narrower window. Nor is the
+         * TT move used there, order_root_moves alone orders the root.
          */
         if (!is_root) {
-            int32_t entry_depth = entry->search_depth;
+            int32_t entry_depth = tt_depth;
             if (entry_depth >= depth) {
-                int32_t entry_eval = entry->position_evaluation;
+                int32_t entry_eval = tt_eval;
+                TT_STAT(tt_stats.usable_hits++);
 
-                switch (entry->node_type) {
+                switch (tt_node_type) {
                     case EXACT:
+                        TT_STAT(tt_stats.cutoffs[EXACT]++);
                         return entry_eval;
                     case LOWER_BOUND:
                         if (entry_eval > alpha) {
                             alpha = entry_eval;
                             if (alpha >= beta) {
-                                beta_count++;
-                                total_moves_before_cutoff++;
+                                thread->stats.beta_count++;
+                                thread->stats.total_moves_before_cutoff++;
+                                TT_STAT(tt_stats.cutoffs[LOWER_BOUND]++);
                                 return entry_eval;  /* fail-high */
                             }
                         }
@@ -275,8 +540,9 @@ static int32_t negamax(Position_t *position, uint8_t depth,
                         if (entry_eval < beta) {
                             beta = entry_eval;
                             if (alpha >= beta) {
-                                beta_count++;
-                                total_moves_before_cutoff++;
+                                thread->stats.beta_count++;
+                                thread->stats.total_moves_before_cutoff++;
+                                TT_STAT(tt_stats.cutoffs[UPPER_BOUND]++);
                                 return entry_eval;  /* fail-low */
                             }
                         }
@@ -288,12 +554,29 @@ static int32_t negamax(Position_t *position, uint8_t depth,
         }
     }
 
+    // ------------------------------------------------------------------
+    // IID (off by default): without a TT move, a shallower search first
+    // lets the TT supply one. Runs before this node generates its children
+    // ------------------------------------------------------------------
+#if INTERNAL_ITERATIVE_DEEPENING
+    if (!is_root && !tt_move_found && depth >= IID_MIN_DEPTH) {
+        int32_t score = negamax(thread, position, depth - IID_REDUCTION,
+                                ply, alpha, beta, NULL);
+        if (score == RAN_OUT_OF_TIME) { return RAN_OUT_OF_TIME; }
+        if (tt_probe(key, depth, &entry)) {
+            tt_move = entry.move;
+            tt_move_found = tt_move != NO_MOVE;
+        }
+    }
+#endif
+
     // ------------------------------------------------------------------
     // Move generation
     // ------------------------------------------------------------------
     if (!is_root) { move_finder(position); }
 
     const uint16_t pos_num_chldrn = position->num_children;
+    const bool in_check = is_check(position, position->white_to_move);
     // ------------------------------------------------------------------
     // Terminal node: no legal moves
     // ------------------------------------------------------------------
@@ -301,50 +584,124 @@ static int32_t negamax(Position_t *position, uint8_t depth,
         // We already know num_children == 0; is_check is sufficient.
         if (__builtin_expect(!is_root, 1)) { free_children_memory(position); }
 
-        return is_check(position, position->white_to_move)
-                   ? -CHECKMATE_VALUE + (searched_depth - depth) : 0; // stalemate
+        return in_check ? -CHECKMATE_VALUE + ply : 0; // stalemate
+    }
+
+    // ------------------------------------------------------------------
+    // Extensions: forcing nodes get their children searched one ply
+    // deeper. Only one extension per node, and none once the line is
+    // already twice as long as the root depth.
+    // ------------------------------------------------------------------
+    const bool can_extend = !is_root
+                         && ply < EXTENSION_PLY_FACTOR * thread->searched_depth;
+    uint8_t extension = 0;
+    if (can_extend) {
+        if (in_check) {
+            extension = 1;
+            thread->stats.check_extensions++;
+        } else if (pos_num_chldrn == 1) {
+            extension = 1;
+            thread->stats.one_reply_extensions++;
+        }
     }
 
     // ------------------------------------------------------------------
     // TT move ordering: move the TT best-move to the front
     // ------------------------------------------------------------------
-    if (tt_move_found) {
+    bool tt_move_first = false;
+    if (!is_root && tt_move_found) {
         for (uint16_t i = 0; i < pos_num_chldrn; i++) {
-            if (position->child_positions[i]->zobrist_key
-                    == entry->best_move_zobrist_key) {
+            if (get_position_move(position->child_positions[i]) == tt_move) {
                 if (i != 0) {
                     Position_t *tmp            = position->child_positions[0];
                     position->child_positions[0] = position->child_positions[i];
                     position->child_positions[i] = tmp;
                 }
+                tt_move_first = true;
                 break;
             }
         }
     }
 
-    uint16_t sort_start = (tt_move_found) ? 1 : 0;
+#if !INTERNAL_ITERATIVE_DEEPENING
+    // ------------------------------------------------------------------
+    // IIR: without a usable TT move, move ordering here is down to MVV-LVA
+    // and killers, so the node is searched one ply shallower
+    // ------------------------------------------------------------------
+    if (!is_root && !tt_move_first && depth >= IIR_MIN_DEPTH) { depth--; }
+#endif
+
+    // ------------------------------------------------------------------
+    // Singular extension: if every alternative to the TT move fails low
+    // against a margin below the TT score in a reduced-depth search, the
+    // TT move is the only good move here and is searched one ply deeper.
+    // ------------------------------------------------------------------
+    uint8_t tt_move_extension = 0;
+    if (can_extend && extension == 0 && tt_move_first
+        && depth >= SINGULAR_MIN_DEPTH
+        && tt_depth + SINGULAR_TT_DEPTH_MARGIN >= depth
+        && tt_node_type != UPPER_BOUND
+        && tt_eval < MATE_THRESHOLD && tt_eval > -MATE_THRESHOLD
+        && pos_num_chldrn > 1)
+    {
+        const int32_t singular_beta = tt_eval - SINGULAR_MARGIN * depth;
+        const uint8_t singular_depth = (depth - 1) / 2;
+        bool singular = true;
+
+        for (uint16_t i = 1; i < pos_num_chldrn; i++) {
+            Position_t *child = position->child_positions[i];
+            insert_past_move_entry(child);
+            int32_t score = negamax(thread, child, singular_depth, ply + 1,
+                                    -singular_beta, -singular_beta + 1, NULL);
+            clear_past_move_entry();
+
+            if (score == RAN_OUT_OF_TIME) {
+                free_children_memory(position);
+                return RAN_OUT_OF_TIME;
+            }
+            if (-score >= singular_beta) { singular = false; break; }
+        }
+
+        if (singular) {
+            tt_move_extension = 1;
+            thread->stats.singular_extensions++;
+        }
+    }
 
     // ------------------------------------------------------------------
-    // Killer move ordering:
+    // PV move ordering: without a TT move (e.g. the entry was overwritten)
+    // the previous iteration's PV move is searched first
     // ------------------------------------------------------------------
-    for (uint16_t i = sort_start; i < pos_num_chldrn; i++) {
-        Position_t* child = position->child_positions[i];
-        if (child->evaluation > KILLER_EVALUATION) { continue; } // skip captures
-        if (child->from_sq == killer_moves[depth][0].from_sq &&
-            child->to_sq == killer_moves[depth][0].to_sq) {
-            child->evaluation = KILLER_EVALUATION;
-        } else if (child->from_sq == killer_moves[depth][1].from_sq &&
-            child->to_sq == killer_moves[depth][1].to_sq) {
-            child->evaluation = KILLER_EVALUATION - 10;
+    bool pv_move_first = false;
+    if (!is_root && on_pv && !tt_move_first) {
+        for (uint16_t i = 0; i < pos_num_chldrn; i++) {
+            if (get_position_move(position->child_positions[i])
+                == thread->followed_pv[ply]) {
+                Position_t *tmp            = position->child_positions[0];
+                position->child_positions[0] = position->child_positions[i];
+                position->child_positions[i] = tmp;
+                pv_move_first = true;
+                break;
+            }
         }
     }
 
+    // ------------------------------------------------------------------
+    // MVV-LVA and killer move ordering (the root is already ordered by
+    // order_root_moves)
+    // ------------------------------------------------------------------
+    uint16_t sort_start = (tt_move_first || pv_move_first) ? 1 : 0;
+    if (is_root) { sort_start = pos_num_chldrn; }
+    MovePicker_t *picker = &ss->picker;
+    move_picker_init(picker, position, sort_start, ss->killers);
+
     // ------------------------------------------------------------------
     // Main negamax loop
     // ------------------------------------------------------------------
 
     int32_t value = INT32_MIN + 2;
     int best_child_idx = -1;
+    uint16_t searched_moves = 0;    // i also counts excluded root moves
 
     for (uint16_t i = 0; i < pos_num_chldrn; i++)
     {
@@ -353,31 +710,27 @@ static int32_t negamax(Position_t *position, uint8_t depth,
             if (__builtin_expect(!is_root, 1)) { free_children_memory(position); }
             return RAN_OUT_OF_TIME;
         }
-   
-        // ------------------------------------------------------------------
-        // MVV - LVA move ordering
-        // ------------------------------------------------------------------
-        if (i >= sort_start) {
-            uint16_t best = i;
-
-            for (uint16_t j = i + 1; j < pos_num_chldrn; j++) {
-                if (position->child_positions[j]->evaluation >
-                    position->child_positions[best]->evaluation) {
-                    best = j;
-                }
-            }
-            if (best != i) {
-                Position_t *tmp = position->child_positions[i];
-                position->child_positions[i] = position->child_positions[best];
-                position->child_positions[best] = tmp;
-            }
-        }
 
-        Position_t *child = position->child_positions[i];
+        const uint16_t child_idx = move_picker_next(picker);
+        Position_t *child = position->child_positions[child_idx];
+        tt_prefetch(child->zobrist_key);
+        if (is_root && thread->num_excluded_root_moves > 0
+            && is_excluded_root_move(thread, child)) { continue; }
+        searched_moves++;
+
+        uint8_t child_depth = depth - 1 + extension
+                            + ((i == 0) ? tt_move_extension : 0);
 
         insert_past_move_entry(child);
-        int32_t score = negamax(child, depth - 1, -beta, -alpha, NULL);
+        ss->current_move = get_position_move(child);
+        thread->follow_pv = on_pv && ss->current_move == thread->followed_pv[ply];
+        const ULL nodes_before = thread->stats.nodes;
+        int32_t score = negamax(thread, child, child_depth, ply + 1,
+                                -beta, -alpha, NULL);
         clear_past_move_entry();
+        if (is_root) {
+            find_root_move(thread, child)->nodes += thread->stats.nodes - nodes_before;
+        }
 
         // check for timeout BEFORE negating. negating RAN_OUT_OF_TIME gives
         // +9997799 which looks like a brilliant move and would corrupt the result.
@@ -392,21 +745,24 @@ static int32_t negamax(Position_t *position, uint8_t depth,
 
         if (score > value) {
             value = score;
-            best_child_idx = i;
+            best_child_idx = child_idx;
         }
         if (value > alpha) {
             alpha = value;
+            update_pv(thread, ply, get_position_move(child));
             if (alpha >= beta) {
-                beta_count++;
-                total_moves_before_cutoff += (i + 1);  // i is 0-indexed
-                if (i == 0) { beta_first_move_count++; }
+                thread->stats.beta_count++;
+                thread->stats.total_moves_before_cutoff += searched_moves;
+                if (searched_moves == 1) { thread->stats.beta_first_move_count++; }
 
                 // Killer move heuristic - if not a capture move and a cutoff move
                 // then store the move to try at the next sibling node
                 bool is_capture = (child->piece_value_diff != position->piece_value_diff);
                 if (!is_capture) {
-                    killer_moves[depth][1] = killer_moves[depth][0];
-                    killer_moves[depth][0] = (Killer_t){child->from_sq, child->to_sq};
+                    if (ss->killers[0] != get_position_move(child)) {
+                        ss->killers[1] = ss->killers[0];
+                        ss->killers[0] = get_position_move(child);
+                    }
                 }
 
                 break; /* Beta cutoff */
@@ -431,68 +787,84 @@ static int32_t negamax(Position_t *position, uint8_t depth,
     // Transposition table store
     // ------------------------------------------------------------------
     if (best_child_idx >= 0) {
-        entry->zobrist_key = key;
-        entry->position_evaluation = value;
-        entry->half_move_count = position->half_move_count;
-        entry->search_depth = depth;
-
+        NodeType_t node_type;
         if (value <= orig_alpha) {
-            entry->node_type = UPPER_BOUND;   // fail-low
+            node_type = UPPER_BOUND;   // fail-low
         } else if (value >= beta) {
-            entry->node_type = LOWER_BOUND;   // fail-high
+            node_type = LOWER_BOUND;   // fail-high
         } else {
-            entry->node_type = EXACT;
+            node_type = EXACT;
         }
-        entry->best_move_zobrist_key =
-            position->child_positions[best_child_idx]->zobrist_key;
+        tt_store(key, value_to_tt(value, ply), depth, node_type,
+                 get_position_move(position->child_positions[best_child_idx]));
     }
 
     free_children_memory(position);
     return value;
 }
 
-static int32_t quiescence(Position_t *position, int32_t alpha, int32_t beta,
-                          uint8_t qdepth)
+static int32_t quiescence(SearchThread_t *thread, Position_t *position,
+                          int32_t alpha, int32_t beta, uint8_t ply)
 {
-    nodes_analysed++;
+    thread->stats.nodes++;
+    if (time_is_up()) { return RAN_OUT_OF_TIME; }
+    if (is_rule_draw(position)) { return 0; }
     bool in_check = is_check(position, position->white_to_move);
 
+    const int32_t orig_alpha = alpha;
+    int32_t stand_pat = 0;
+    SearchStack_t *ss = &thread->stack[ply];
+    ss->static_eval = EVAL_NONE;
+
+    // stand-pat cuts are checked first: they are far cheaper than a TT probe
     if (!in_check) {
-        int32_t stand_pat = evaluate_position(position);
+        stand_pat = evaluate_position(position);
+        ss->static_eval = stand_pat;
         if (stand_pat >= beta) { return stand_pat;} // beta cut
-        if (stand_pat > alpha) { alpha = stand_pat;} // raise minimum alpha
+        // even the largest possible gain cannot reach alpha
+        if (stand_pat + BIG_DELTA_MARGIN <= alpha) { return alpha; }
     }
 
-    // depth limit
-    // Not in check: stand-pat is a valid return.
-    // In checkmate: return mate score
-    // In check: generate escape moves
-    if (qdepth == 0) {
-        if (!in_check) { return alpha; }
+    // ------------------------------------------------------------------
+    // Transposition table - any stored depth is enough for quiescence
+    // ------------------------------------------------------------------
+    const ULL key = position->zobrist_key;
+    TranspositionData_t entry;
+    bool tt_move_found = false;
+    Move_t tt_move = NO_MOVE;
 
-        move_finder(position);
-        uint16_t num_children = position->num_children;
-        if (num_children == 0) { // checkmate
-            free_children_memory(position);
-            return -CHECKMATE_VALUE + searched_depth + MAX_QUIESCENCE_DEPTH;
-        }
-        for (uint16_t i = 0; i < num_children; i++) {
-            Position_t *child = position->child_positions[i];
-            insert_past_move_entry(child);
-            int32_t score = -quiescence(child, -beta, -alpha, 0);
-            clear_past_move_entry();
-            if (score > alpha) {
-                alpha = score;
-                if (alpha >= beta) {
-                    free_children_memory(position);
-                    return alpha;
+    if (tt_probe(key, 0, &entry)) {
+        tt_move_found = true;
+        tt_move = entry.move;
+        int32_t entry_eval = value_from_tt(entry.eval, ply);
+        TT_STAT(tt_stats.usable_hits++);    // any depth is enough here
+
+        switch (tt_data_bound(&entry)) {
+            case EXACT:
+                TT_STAT(tt_stats.cutoffs[EXACT]++);
+                return entry_eval;
+            case LOWER_BOUND:
+                if (entry_eval >= beta) {
+                    TT_STAT(tt_stats.cutoffs[LOWER_BOUND]++);
+                    return entry_eval;
                 }
-            }
+                break;
+            case UPPER_BOUND:
+                if (entry_eval <= alpha) {
+                    TT_STAT(tt_stats.cutoffs[UPPER_BOUND]++);
+                    return entry_eval;
+                }
+                break;
+            default:
+                break;
         }
-        free_children_memory(position);
-        return alpha;
     }
 
+    if (!in_check && stand_pat > alpha) { alpha = stand_pat; } // raise minimum alpha
+
+    // safety net for the memory pool - captures normally end long before
+    if (ply >= MAX_PLY) { return in_check ? evaluate_position(position) : alpha; }
+
     move_finder(position);
     uint16_t num_children = position->num_children;
 
@@ -500,47 +872,67 @@ static int32_t quiescence(Position_t *position, int32_t alpha, int32_t beta,
     if (num_children == 0) {
         free_children_memory(position);
         if (in_check) { //checkmate
-            return -CHECKMATE_VALUE + searched_depth + (MAX_QUIESCENCE_DEPTH - qdepth);
+            return -CHECKMATE_VALUE + ply;
         } else { return 0; } // stalemate
     }
 
-    // at this point we are not at depth limit, nor are we at a terminal node
-    // so now we can do what we need to - do a capture search branch
+    // ------------------------------------------------------------------
+    // TT move ordering: move the TT best-move to the front
+    // ------------------------------------------------------------------
+    uint16_t sort_start = 0;
+    if (tt_move_found) {
+        for (uint16_t i = 0; i < num_children; i++) {
+            if (get_position_move(position->child_positions[i]) == tt_move) {
+                Position_t *tmp = position->child_positions[0];
+                position->child_positions[0] = position->child_positions[i];
+                position->child_positions[i] = tmp;
+                sort_start = 1;
+                break;
+            }
+        }
+    }
+
+    // at this point we are not at a terminal node, so search the captures
+    // (or every evasion when in check)
+
+    // MVV-LVA ordering, the best capture is picked lazily from the rest
+    MovePicker_t *picker = &ss->picker;
+    move_picker_init(picker, position, sort_start, NULL);
 
     int32_t parent_diff = position->piece_value_diff;
+    Move_t best_move = NO_MOVE;
     for (uint16_t i = 0; i < num_children; i++) {
+        Position_t* child = position->child_positions[move_picker_next(picker)];
 
-        // ------------------------------------------------------------------
-        // MVV - LVA move ordering
-        // ------------------------------------------------------------------
-        // lazy sort - find best capture from i onwards and swap it here
-        uint16_t best = i;
-        for (uint16_t j = i + 1; j < position->num_children; j++) {
-            if (position->child_positions[j]->evaluation >
-                position->child_positions[best]->evaluation) {
-                best = j;
-            }
-        }
-        if (best != i) {
-            Position_t *tmp = position->child_positions[i];
-            position->child_positions[i] = position->child_positions[best];
-            position->child_positions[best] = tmp;
-        }
-
-        Position_t* child = position->child_positions[i];
+        // material won by the move: the victim, plus any promotion gain
+        int32_t gain = abs(child->piece_value_diff - parent_diff);
 
-        // skip children that don't have captures:
-        if (!in_check && child->piece_value_diff == parent_diff) { continue; }
+        if (!in_check) {
+            // skip children that don't have captures:
+            if (gain == 0) { continue; }
+            // delta pruning - this capture cannot bring us back to alpha
+            if (stand_pat + gain + DELTA_MARGIN <= alpha) { continue; }
+        }
 
         // otherwise compute children recursively:
+        tt_prefetch(child->zobrist_key);
         insert_past_move_entry(child);
-        int32_t score = -quiescence(child, -beta, -alpha, qdepth - 1);
+        ss->current_move = get_position_move(child);
+        int32_t score = quiescence(thread, child, -beta, -alpha, ply + 1);
         clear_past_move_entry();
 
+        if (score == RAN_OUT_OF_TIME) {
+            free_children_memory(position);
+            return RAN_OUT_OF_TIME;
+        }
+        score = -score;
+
         // alpha-beta cutoff:
         if (score > alpha) {
             alpha = score; // update alpha to meet minimum expected value
+            best_move = get_position_move(child);
             if (alpha >= beta) {
+                tt_store(key, value_to_tt(alpha, ply), 0, LOWER_BOUND, best_move);
                 free_children_memory(position);
                 return alpha; // beta cut-off
             }
@@ -548,30 +940,73 @@ static int32_t quiescence(Position_t *position, int32_t alpha, int32_t beta,
     }
 
     // normal return path
+    tt_store(key, value_to_tt(alpha, ply), 0,
+             (alpha > orig_alpha) ? EXACT : UPPER_BOUND, best_move);
     free_children_memory(position);
     return alpha;
 }
 
+void set_search_info_output(bool enabled)
+{ search_info_output = enabled; }
+
+bool get_search_info_output(void)
+{ return search_info_output; }
+
+ULL get_nodes_analysed(void)
+{ return main_thread.stats.nodes; }
+
 void print_stats(void)
 {
-    float beta_rate = interior_nodes > 0
-                    ? (float)beta_count * 100.0f / (float)interior_nodes
+    const SearchStats_t *stats = &main_thread.stats;
+
+    float beta_rate = stats->interior_nodes > 0
+                    ? (float)stats->beta_count * 100.0f / (float)stats->interior_nodes
                     : 0.0f;
-    float first_move_rate = beta_count > 0
-                           ? (float)beta_first_move_count * 100.0f / (float)beta_count
+    float first_move_rate = stats->beta_count > 0
+                           ? (float)stats->beta_first_move_count * 100.0f / (float)stats->beta_count
                            : 0.0f;
-    float avg = beta_count > 0 ? (float)total_moves_before_cutoff / beta_count : 0.0f;
+    float avg = stats->beta_count > 0
+              ? (float)stats->total_moves_before_cutoff / stats->beta_count
+              : 0.0f;
 
-    float aspiration_fail_rate = aspiration_attempts > 0
-                               ? (float)aspiration_failures * 100.0f / (float)aspiration_attempts
+    float aspiration_fail_rate = stats->aspiration_attempts > 0
+                               ? (float)stats->aspiration_failures * 100.0f / (float)stats->aspiration_attempts
                                : 0.0f;
 
     printf("Depth: %u | Nodes: %llu | Eval: %d | "
-           "A. fail rate: %.1f%% | "
+           "A. fail rate: %.1f%% (hi/lo %u/%u) | "
            "Beta: %.1f%% | 1st move: %.1f%% | "
-           "Avg bef. cut: %.2f\n",
-           completed_depth, nodes_analysed, best_eval,
-           aspiration_fail_rate,
-           beta_rate, first_move_rate, avg);
+           "Avg bef. cut: %.2f | "
+           "Ext chk/1rep/sing: %llu/%llu/%llu",
+           main_thread.completed_depth, stats->nodes, main_thread.best_eval,
+           aspiration_fail_rate, stats->aspiration_fail_highs,
+           stats->aspiration_fail_lows,
+           beta_rate, first_move_rate, avg,
+           stats->check_extensions, stats->one_reply_extensions,
+           stats->singular_extensions);
+
+    long long stop_latency = time_manager_stop_latency_us();
+    if (stop_latency >= 0) { printf(" | Stop latency: %lldus", stop_latency); }
+    printf(" | Hashfull: %u\n", hash_table_hashfull());
+
+#if TT_STATS
+    float hit_rate = tt_stats.probes > 0
+                   ? (float)tt_stats.hits * 100.0f / (float)tt_stats.probes
+                   : 0.0f;
+    printf("TT probes: %llu | Hits: %.1f%% (usable %llu) | "
+           "Cutoffs exact/lower/upper: %llu/%llu/%llu | "
+           "Stores: %llu (updates %llu, replacements %llu)\n",
+           tt_stats.probes, hit_rate, tt_stats.usable_hits,
+           tt_stats.cutoffs[EXACT], tt_stats.cutoffs[LOWER_BOUND],
+           tt_stats.cutoffs[UPPER_BOUND],
+           tt_stats.stores, tt_stats.updates, tt_stats.replacements);
+#if TT_NEAR_ROOT
+    float near_root_hit_rate = tt_stats.near_root_probes > 0
+        ? (float)tt_stats.near_root_hits * 100.0f / (float)tt_stats.near_root_probes
+        : 0.0f;
+    printf("Near-root TT probes: %llu | Hits: %.1f%% | Stores: %llu\n",
+           tt_stats.near_root_probes, near_root_hit_rate, tt_stats.near_root_stores);
+#endif
+#endif
 }
 
@@ -11,16 +11,144 @@
 #include <stdint.h>
 
 #include "../movefinding/board.h"
+#include "evaluate.h"
+#include "timeman.h"
+#include "movepicker.h"
 
 #define RAN_OUT_OF_TIME -9997799
 
 #define FULL_ASPIRATION_WINDOW_DEPTH 4
-#define ASPIRATION_WINDOW 50
+// The aspiration window is ASPIRATION_MIN_WINDOW plus the average score
+// change of recent iterations on each side. After a fail only the failing
+// side is widened, by half the window each time, and opened fully once
+// the window passes ASPIRATION_MAX_WINDOW.
+#define ASPIRATION_MIN_WINDOW 10
+#define ASPIRATION_INITIAL_VOLATILITY 25
+#define ASPIRATION_MAX_WINDOW 1000
 
 #define MAX_SEARCH_DEPTH 64
-#define MAX_QUIESCENCE_DEPTH 5
 
-#define KILLER_EVALUATION 90
+#define MATE_THRESHOLD (CHECKMATE_VALUE - 1000)
+
+// Extensions are only granted while ply < EXTENSION_PLY_FACTOR * root depth
+#define EXTENSION_PLY_FACTOR 2
+#define SINGULAR_MIN_DEPTH 6
+#define SINGULAR_TT_DEPTH_MARGIN 3
+#define SINGULAR_MARGIN 2
+
+// Nodes without a TT move: reduce them (IIR) or, with
+// INTERNAL_ITERATIVE_DEEPENING set, search them shallower first (IID)
+#ifndef INTERNAL_ITERATIVE_DEEPENING
+#define INTERNAL_ITERATIVE_DEEPENING 0
+#endif
+#define IIR_MIN_DEPTH 4
+#define IID_MIN_DEPTH 5
+#define IID_REDUCTION 2
+
+// Quiescence delta pruning: skip captures that cannot raise alpha even
+// with this margin added to the captured material
+#define DELTA_MARGIN 200
+#define BIG_DELTA_MARGIN (2 * QUEEN_VALUE - PAWN_VALUE + DELTA_MARGIN)
+
+#define MAX_PV_LENGTH MAX_SEARCH_DEPTH
+
+/**
+ * @brief One root move and its principal variation, as found by the search.
+ */
+typedef struct {
+    Move_t pv[MAX_PV_LENGTH];   // pv[0] is the root move
+    uint8_t pv_length;
+    int32_t score;              // from the side to move at the root
+    uint8_t depth;              // depth the line was completed at
+} SearchLine_t;
+
+// static_eval of a node that was not evaluated
+#define EVAL_NONE INT32_MIN
+
+/**
+ * @brief Search state of one ply, indexed by distance from the root.
+ */
+typedef struct {
+    Move_t killers[2];      // quiet moves that caused a beta cutoff at this ply
+    Move_t current_move;    // move being searched from this ply
+    int32_t static_eval;    // EVAL_NONE if the node was not evaluated
+    MovePicker_t picker;
+} SearchStack_t;
+
+/**
+ * @brief A child of the root and the effort spent searching it.
+ */
+typedef struct {
+    Position_t *position;
+    ULL nodes;              // nodes below this move in the current iteration
+    ULL previous_nodes;     // ... and in the previous one, used for ordering
+} RootMove_t;
+
+/**
+ * @brief Counters of one search, reported by print_stats().
+ */
+typedef struct {
+    ULL nodes;                  // including quiescence nodes
+    ULL interior_nodes;
+    uint32_t aspiration_attempts;
+    uint32_t aspiration_failures;       // depths that needed a re-search
+    uint32_t aspiration_fail_highs;     // re-searches after failing high
+    uint32_t aspiration_fail_lows;      // ... and after failing low
+    uint32_t beta_count;
+    uint32_t beta_first_move_count;
+    uint64_t total_moves_before_cutoff;
+    ULL check_extensions;
+    ULL one_reply_extensions;
+    ULL singular_extensions;
+} SearchStats_t;
+
+/**
+ * @brief All the state of one search, passed through negamax and quiescence.
+ *
+ * Searches on separate SearchThread_t do not share search state. They do
+ * share the transposition table, the time manager and the move generation
+ * globals.
+ */
+typedef struct {
+    SearchStack_t stack[MAX_PLY + 1];
+
+    // triangular PV table: pv_table[ply] holds the best line found from
+    // the node at ply, pv_length[ply] moves long
+    Move_t pv_table[MAX_PLY + 1][MAX_PLY + 1];
+    uint8_t pv_length[MAX_PLY + 1];
+
+    // PV of the previous iteration, follow_pv is only set while the
+    // current node is on it
+    Move_t followed_pv[MAX_PV_LENGTH];
+    uint8_t followed_pv_length;
+    bool follow_pv;
+
+    // children of the root, in the order they are searched
+    RootMove_t root_moves[MAX_CHILDREN];
+    uint16_t num_root_moves;
+
+    // root moves already found in this iteration of a MultiPV search
+    ULL excluded_root_moves[MAX_CHILDREN];
+    uint16_t num_excluded_root_moves;
+
+    // lines of the running iteration, copied out once every line finished
+    SearchLine_t iteration_lines[MAX_CHILDREN];
+
+    // iterative deepening
+    int32_t best_eval;
+    int32_t prev_eval;
+    int32_t score_volatility;   // average score change between iterations
+    uint8_t searched_depth;
+    uint8_t completed_depth;
+
+    // time manager input
+    uint8_t best_move_stability;
+    ULL last_best_move_key;
+    int32_t score_drop;
+    uint8_t best_move_effort;   // % of the last iteration's nodes
+
+    SearchStats_t stats;
+} SearchThread_t;
 
 /**
  * @brief Negamax search algorithm for a given position and depth.
@@ -31,16 +159,61 @@
  * @param position The current position to evaluate.
  * @param best_move The position to store the best move found.
  * @param max_depth The maximum depth to search.
- * @param max_time The maximum time allowed for the search.
+ * @param limits The soft and hard time limits for the search.
  */
 int32_t find_best_move(Position_t* position, 
                        Position_t* return_best_move, 
                        uint8_t max_depth,
-                       long long max_time);
+                       TimeLimits_t limits);
+
+/**
+ * @brief Searches the best num_lines root moves (MultiPV).
+ *
+ * Every iteration searches the root once per line, each time excluding
+ * the moves already found in that iteration, so line k is the best move
+ * after the first k. The lines share the transposition table.
+ *
+ * @param position The current position to evaluate.
+ * @param lines Array of num_lines lines, filled best first.
+ * @param num_lines The number of moves to find.
+ * @param max_depth The maximum depth to search.
+ * @param limits The soft and hard time limits for the search.
+ * @return The number of lines filled: num_lines, or fewer if there are
+ * fewer legal moves.
+ */
+uint8_t find_best_moves(Position_t* position,
+                        SearchLine_t* lines,
+                        uint8_t num_lines,
+                        uint8_t max_depth,
+                        TimeLimits_t limits);
+
+/**
+ * @brief Enables or disables an info line per completed iteration.
+ *
+ * Each line gives depth, score, nodes, nodes per second, time and PV.
+ * Off by default. Must not be changed while a search runs.
+ *
+ * @param enabled true to print the info lines.
+ */
+void set_search_info_output(bool enabled);
+
+/**
+ * @brief Checks whether info lines are printed per iteration.
+ *
+ * @return true if set_search_info_output(true) was called.
+ */
+bool get_search_info_output(void);
 
 /**
  * @brief Prints the statistics of the search.
  */
 void print_stats(void);
 
+/**
+ * @brief Gets the number of nodes searched by the last search.
+ *
+ * @return The node count, including quiescence nodes.
+ */
+ULL get_nodes_analysed(void);
+
 #endif // SEARCH_H
@@ -0,0 +1,221 @@
+// timeman.c
+
+// pthread_condattr_setclock and clock_gettime are POSIX, not plain C17
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "timeman.h"
+
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+// soft limit scaling (percent) by consecutive iterations with the same
+// best move: a move that just changed gets more time, a settled one less
+static const int stability_scale[] = { 125, 100, 85, 70, 60 };
+#define MAX_STABILITY (sizeof(stability_scale) / sizeof(stability_scale[0]) - 1)
+
+atomic_bool search_stop_flag = false;
+
+// limits and timer thread state, protected by timer_mutex as the limits
+// may be replaced from another thread while the search runs
+static pthread_mutex_t timer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static TimeLimits_t current_limits;
+static long long search_start_ms = 0;
+static bool search_running = false;
+static pthread_t timer_thread;
+static pthread_cond_t timer_cond;
+static pthread_once_t timer_cond_once = PTHREAD_ONCE_INIT;
+static bool timer_running = false;
+static bool timer_cancelled = false;
+
+static atomic_llong stop_requested_us = 0;
+static long long stop_latency_us = -1;
+
+static long long get_monotonic_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000LL;
+}
+
+long long get_monotonic_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000LL + ts.tv_nsec / 1000000LL;
+}
+
+TimeLimits_t time_limits_fixed(long long move_time)
+{
+    return (TimeLimits_t){ move_time, move_time, false };
+}
+
+TimeLimits_t time_limits_infinite(void)
+{
+    return (TimeLimits_t){ TIME_LIMIT_INFINITE, TIME_LIMIT_INFINITE, false };
+}
+
+TimeLimits_t time_limits_from_clock(long long remaining,
+                                    long long increment,
+                                    uint16_t half_move_count)
+{
+    long long available = remaining - MOVE_OVERHEAD_MS;
+    if (available < MIN_SEARCH_TIME_MS) {
+        return (TimeLimits_t){ MIN_SEARCH_TIME_MS, MIN_SEARCH_TIME_MS, false };
+    }
+
+    long long moves_to_go = MAX(MIN_MOVES_TO_GO,
+                                DEFAULT_MOVES_TO_GO - half_move_count / 2);
+
+    long long soft = available / moves_to_go + increment * 3 / 4;
+    long long hard = MIN(soft * HARD_LIMIT_FACTOR,
+                         available / HARD_LIMIT_REMAINING_DIVISOR + increment);
+    hard = MIN(hard, available);
+    soft = MIN(soft, hard);
+
+    return (TimeLimits_t){ MAX(soft, MIN_SEARCH_TIME_MS),
+                           MAX(hard, MIN_SEARCH_TIME_MS), true };
+}
+
+static void request_stop(void)
+{
+    // only the first request counts towards the stop latency
+    long long expected = 0;
+    atomic_compare_exchange_strong(&stop_requested_us, &expected, get_monotonic_us());
+    atomic_store_explicit(&search_stop_flag, true, memory_order_relaxed);
+}
+
+static void timer_cond_init(void)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&timer_cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+static void* timer_loop(void* arg)
+{
+    (void)arg; // Unused parameter
+
+    pthread_mutex_lock(&timer_mutex);
+    while (!timer_cancelled) {
+        // re-read on every wake-up, the deadline may have been moved
+        if (current_limits.hard_limit == TIME_LIMIT_INFINITE) {
+            pthread_cond_wait(&timer_cond, &timer_mutex);
+            continue;
+        }
+        long long deadline = search_start_ms + current_limits.hard_limit;
+        struct timespec ts = { deadline / 1000, (deadline % 1000) * 1000000L };
+        int result = pthread_cond_timedwait(&timer_cond, &timer_mutex, &ts);
+        if (result == ETIMEDOUT
+            && get_monotonic_ms() >= search_start_ms + current_limits.hard_limit) {
+            request_stop();
+            break;
+        }
+    }
+    pthread_mutex_unlock(&timer_mutex);
+    return NULL;
+}
+
+void time_manager_start(TimeLimits_t limits)
+{
+    pthread_once(&timer_cond_once, timer_cond_init);
+    if (timer_running) { time_manager_finish(); }
+
+    atomic_store(&stop_requested_us, 0);
+    atomic_store(&search_stop_flag, false);
+    stop_latency_us = -1;
+
+    pthread_mutex_lock(&timer_mutex);
+    current_limits = limits;
+    search_start_ms = get_monotonic_ms();
+    search_running = true;
+    timer_cancelled = false;
+    pthread_mutex_unlock(&timer_mutex);
+
+    timer_running = (pthread_create(&timer_thread, NULL, timer_loop, NULL) == 0);
+}
+
+void time_manager_finish(void)
+{
+    long long requested = atomic_load(&stop_requested_us);
+    if (requested != 0) { stop_latency_us = get_monotonic_us() - requested; }
+
+    pthread_mutex_lock(&timer_mutex);
+    search_running = false;
+    timer_cancelled = true;
+    pthread_cond_signal(&timer_cond);
+    pthread_mutex_unlock(&timer_mutex);
+
+    if (timer_running) {
+        pthread_join(timer_thread, NULL);
+        timer_running = false;
+    }
+
+    atomic_store(&search_stop_flag, false);
+}
+
+bool time_manager_set_limits(TimeLimits_t limits)
+{
+    pthread_mutex_lock(&timer_mutex);
+    bool applied = search_running;
+    if (applied) {
+        current_limits = limits;
+        search_start_ms = get_monotonic_ms();
+        pthread_cond_signal(&timer_cond); // wake the timer for the new deadline
+    }
+    pthread_mutex_unlock(&timer_mutex);
+    return applied;
+}
+
+void time_manager_stop_search(void)
+{ request_stop(); }
+
+long long time_manager_stop_latency_us(void)
+{ return stop_latency_us; }
+
+long long time_manager_elapsed(void)
+{
+    pthread_mutex_lock(&timer_mutex);
+    long long elapsed = get_monotonic_ms() - search_start_ms;
+    pthread_mutex_unlock(&timer_mutex);
+    return elapsed;
+}
+
+bool time_manager_hard_stop(void)
+{
+    pthread_mutex_lock(&timer_mutex);
+    TimeLimits_t limits = current_limits;
+    pthread_mutex_unlock(&timer_mutex);
+
+    return search_stop_requested()
+        || time_manager_elapsed() >= limits.hard_limit;
+}
+
+bool time_manager_soft_stop(uint8_t best_move_stability, int32_t score_drop,
+                            uint8_t best_move_effort)
+{
+    pthread_mutex_lock(&timer_mutex);
+    TimeLimits_t limits = current_limits;
+    pthread_mutex_unlock(&timer_mutex);
+
+    long long soft = limits.soft_limit;
+
+    if (limits.adaptive) {
+        soft = soft * stability_scale[MIN(best_move_stability, MAX_STABILITY)] / 100;
+        if (score_drop > LARGE_SCORE_DROP_MARGIN) { soft *= 2; }
+        else if (score_drop > SCORE_DROP_MARGIN) { soft = soft * 3 / 2; }
+        if (best_move_effort >= HIGH_BEST_MOVE_EFFORT) { soft = soft * 3 / 4; }
+        else if (best_move_effort < LOW_BEST_MOVE_EFFORT) { soft = soft * 5 / 4; }
+        soft = MIN(soft, limits.hard_limit);
+    }
+
+    return time_manager_elapsed() >= soft;
+}
@@ -0,0 +1,176 @@
+/**
+ * @file timeman.h
+ * @brief Wall-clock time management for the search
+ * @author Philip Brand
+ * @date 2026-10-19
+ *
+ * All times are in milliseconds of CLOCK_MONOTONIC time, so they track the
+ * real clock regardless of CPU load or the number of threads running.
+ *
+ * The search gets two deadlines:
+ * - soft: no new iteration is started after this (scaled by how stable
+ *   the best move is, extended when the score drops, and scaled by the
+ *   share of the nodes the best move took)
+ * - hard: the running iteration is abandoned
+ *
+ * The hard deadline is enforced by a timer thread that sets an atomic stop
+ * flag, which the search polls at every node. Other threads (GUI, protocol
+ * readers) can set the same flag with time_manager_stop_search().
+ */
+
+#ifndef TIMEMAN_H
+#define TIMEMAN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <limits.h>
+
+// time kept back per move for move output and process scheduling
+#define MOVE_OVERHEAD_MS 30
+#define MIN_SEARCH_TIME_MS 10
+
+// expected number of moves still to play, shrinking as the game goes on
+#define DEFAULT_MOVES_TO_GO 40
+#define MIN_MOVES_TO_GO 20
+
+// hard limit: at most this multiple of the soft limit,
+// and never more than 1 / HARD_LIMIT_REMAINING_DIVISOR of the clock
+#define HARD_LIMIT_FACTOR 4
+#define HARD_LIMIT_REMAINING_DIVISOR 3
+
+// a score drop of more than this (in centipawns) between iterations
+// extends the soft limit
+#define SCORE_DROP_MARGIN 30
+#define LARGE_SCORE_DROP_MARGIN 100
+
+// share of the nodes (%) spent on the best move: above HIGH the other
+// moves were refuted quickly, below LOW they were hard to refute
+#define HIGH_BEST_MOVE_EFFORT 90
+#define LOW_BEST_MOVE_EFFORT 40
+
+// no deadline at all: the search runs until stopped (pondering)
+#define TIME_LIMIT_INFINITE LLONG_MAX
+
+typedef struct {
+    long long soft_limit;   // ms after the search starts
+    long long hard_limit;   // ms after the search starts
+    bool adaptive;          // scale soft_limit by stability and score drops
+} TimeLimits_t;
+
+extern atomic_bool search_stop_flag;
+
+/**
+ * @brief Checks whether the running search has been told to stop.
+ *
+ * Cheap enough to call at every node.
+ *
+ * @return true once the hard deadline has passed or a stop was requested.
+ */
+static inline bool search_stop_requested(void)
+{ return atomic_load_explicit(&search_stop_flag, memory_order_relaxed); }
+
+/**
+ * @brief Gets the monotonic (wall) clock time.
+ *
+ * @return The time in milliseconds since an arbitrary fixed point.
+ */
+long long get_monotonic_ms(void);
+
+/**
+ * @brief Time limits for a fixed time per move.
+ *
+ * @param move_time The time allowed for the move in milliseconds.
+ * @return Limits with both deadlines at move_time.
+ */
+TimeLimits_t time_limits_fixed(long long move_time);
+
+/**
+ * @brief Time limits for a search that only ends when stopped.
+ *
+ * @return Limits with both deadlines at TIME_LIMIT_INFINITE.
+ */
+TimeLimits_t time_limits_infinite(void);
+
+/**
+ * @brief Time limits for a move when playing on a clock.
+ *
+ * @param remaining The time left on the engine's clock in milliseconds.
+ * @param increment The engine's increment per move in milliseconds.
+ * @param half_move_count The number of half moves played in the game.
+ * @return Soft and hard limits for this move.
+ */
+TimeLimits_t time_limits_from_clock(long long remaining,
+                                    long long increment,
+                                    uint16_t half_move_count);
+
+/**
+ * @brief Starts timing a search against the given limits.
+ *
+ * Clears the stop flag and starts the timer thread for the hard deadline.
+ *
+ * @param limits The limits for this search.
+ */
+void time_manager_start(TimeLimits_t limits);
+
+/**
+ * @brief Ends timing of the current search.
+ *
+ * Stops the timer thread, records the stop latency and clears the stop flag.
+ */
+void time_manager_finish(void);
+
+/**
+ * @brief Replaces the limits of the running search and restarts its clock.
+ *
+ * Used on a ponder hit, to turn an infinite search into a timed one.
+ * Safe to call from any thread.
+ *
+ * @param limits The new limits, counted from now.
+ * @return false if no search is running, so the limits were not applied.
+ */
+bool time_manager_set_limits(TimeLimits_t limits);
+
+/**
+ * @brief Asks the running search to stop as soon as possible.
+ *
+ * Safe to call from any thread. The search keeps its last completed depth.
+ */
+void time_manager_stop_search(void);
+
+/**
+ * @brief Gets how long the last search took to stop once told to.
+ *
+ * @return The latency in microseconds, or -1 if the last search was not stopped.
+ */
+long long time_manager_stop_latency_us(void);
+
+/**
+ * @brief Gets the time elapsed since time_manager_start().
+ *
+ * @return The elapsed time in milliseconds.
+ */
+long long time_manager_elapsed(void);
+
+/**
+ * @brief Checks whether the hard deadline has passed or a stop was requested.
+ *
+ * @return true if the search must stop immediately.
+ */
+bool time_manager_hard_stop(void);
+
+/**
+ * @brief Checks whether another iteration should be started.
+ *
+ * @param best_move_stability Number of consecutive iterations that
+ * returned the same best move.
+ * @param score_drop How far the score fell in the last iteration
+ * (negative if it rose).
+ * @param best_move_effort Percentage of the last iteration's nodes that
+ * were spent below the best move.
+ * @return true if the search should stop after the current iteration.
+ */
+bool time_manager_soft_stop(uint8_t best_move_stability, int32_t score_drop,
+                            uint8_t best_move_effort);
+
+#endif // TIMEMAN_H
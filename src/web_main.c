@@ -14,6 +14,7 @@
 #include "./movefinding/memory.h"
 #include "./search/search.h"
 #include "./search/hash_tables.h"
+#include "./search/ponder.h"
 #include "./gui/gui.h"
 #include "./interface/ui.h"
 #include "./interface/movedisplay.h"
@@ -31,6 +32,7 @@ static char previous_fen_string[FEN_LENGTH] = {0};
 static char fen_string[FEN_LENGTH] = {0};
 
 bool play_game(Position_t* position);
+bool play_engine_move(void);
 bool update_game(void);
 void init(void);
 void cli_game_loop(void* arg);
@@ -48,6 +50,7 @@ void cli_game_loop(void* arg)
     (void)arg; // Unused parameter
     set_time(1);
     set_colour(&playing_as_white);
+    hash_table_new_game();
     start_clock(); // Start the clock for the first player
 
     while (1) { if (!play_game(&old_position)) 
@@ -70,7 +73,8 @@ bool play_game(Position_t* position)
         first_move = false;
     }
 
-    // user move
+    // user move - the engine ponders on the expected reply meanwhile
+    bool pondering = ponder_start(position);
     bool success = 0;
     while (!success) {
         bool success1 = read_fen_from_stdin(fen_string);
@@ -80,6 +84,22 @@ bool play_game(Position_t* position)
         set_time(atoi(time));
         pad_fen_to_full_length(fen_string);
         fen_to_board(fen_string, &new_position);
+
+        if (pondering) {
+            pondering = false;
+            if (success1 && !is_different(&new_position, get_ponder_position())) {
+                // ponder hit - the running search becomes the engine's move search,
+                // the game end check waits for it as it generates moves
+                old_position = *get_ponder_position();
+                switch_time_decrement();
+                update_time_display();
+                ponder_hit(get_next_move_search_time(), &new_position);
+                if (is_game_ended(&old_position)) { return 0; }
+                return play_engine_move();
+            }
+            ponder_miss();
+        }
+
         char move_notation[MOVE_NOTATION_LENGTH] = {0};
         get_move_notation(position, &new_position, move_notation);
         bool success2 = make_move_from_san(position, &new_position, move_notation);
@@ -93,6 +113,12 @@ bool play_game(Position_t* position)
 
     // engine move
     find_best_move(position, &new_position, 20, get_next_move_search_time());
+    return play_engine_move();
+}
+
+// sends the engine's move (in new_position) and applies it
+bool play_engine_move(void)
+{
     board_to_fen(&new_position, fen_string);
     memcpy(previous_fen_string, fen_string, FEN_LENGTH);
     printf("%s\n", fen_string); fflush(stdout);
@@ -123,7 +149,7 @@ void init(void)
     custom_memory_init();
     move_finder_init();
     zobrist_key_init();
-    hash_table_init();
+    hash_table_init(DEFAULT_HASH_MB);
     ui_init();
     fen_to_board(new, &old_position);
     insert_past_move_entry(&old_position);